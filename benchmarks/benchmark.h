@@ -0,0 +1,27 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <string_view>
+
+namespace benchmark {
+
+    // Лучшее время из runs запусков func в миллисекундах: минимум меньше всего зависит от помех
+    template <typename Func>
+    double MeasureBest(int runs, Func func) {
+        double best = std::numeric_limits<double>::max();
+        for (int i = 0; i < runs; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            func();
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    }
+
+    inline void PrintResult(std::string_view name, double ms, std::ostream& out = std::cout) {
+        out << name << ": " << ms << " ms\n";
+    }
+}
@@ -0,0 +1,82 @@
+#include "benchmark.h"
+#include "json.h"
+#include "json_writer.h"
+
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+    // base_requests из count остановок: по две координаты и несколько расстояний на остановку
+    std::string MakeStopsJson(int count) {
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<double> latitude(43.5, 43.7);
+        std::uniform_real_distribution<double> longitude(39.6, 39.8);
+        std::uniform_int_distribution<int> distance(100, 5000);
+
+        std::ostringstream out;
+        out.precision(17);
+        out << "{\"base_requests\": ["sv;
+        for (int i = 0; i < count; ++i) {
+            if (i > 0) {
+                out << ", "sv;
+            }
+            out << "{\"type\": \"Stop\", \"name\": \"S"sv << i << "\", \"latitude\": "sv << latitude(generator)
+                << ", \"longitude\": "sv << longitude(generator) << ", \"road_distances\": {"sv;
+            for (int j = 1; j <= 3; ++j) {
+                out << (j > 1 ? ", "sv : ""sv) << "\"S"sv << (i + j) % count << "\": "sv << distance(generator);
+            }
+            out << "}}"sv;
+        }
+        out << "]}"sv;
+        return out.str();
+    }
+}
+
+// Разбор и вывод чисел в слое JSON: координаты в base_requests и время в ответах Route.
+// Аргументы: число остановок (по умолчанию 100000) и число повторов (по умолчанию 5)
+int main(int argc, char* argv[]) {
+    const int count = argc > 1 ? std::atoi(argv[1]) : 100000;
+    const int runs = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    const std::string text = MakeStopsJson(count);
+    size_t checksum = 0;
+
+    benchmark::PrintResult("load"sv, benchmark::MeasureBest(runs, [&] {
+        const json::Document doc = json::Load(std::string_view(text));
+        checksum += doc.GetRoot().AsDict().at("base_requests"sv).AsArray().size();
+    }));
+
+    const json::Document doc = json::Load(std::string_view(text));
+    benchmark::PrintResult("print"sv, benchmark::MeasureBest(runs, [&] {
+        std::ostringstream out;
+        json::Print(doc, out);
+        checksum += out.str().size();
+    }));
+
+    //Ответ Route: время каждого участка выводится числом с плавающей точкой
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> time(0.5, 60.0);
+    std::vector<double> times(static_cast<size_t>(count) * 4);
+    for (double& value : times) {
+        value = time(generator);
+    }
+    benchmark::PrintResult("write_doubles"sv, benchmark::MeasureBest(runs, [&] {
+        std::ostringstream out;
+        {
+            json::Writer writer(out, json::Writer::Format::COMPACT);
+            writer.StartArray();
+            for (double value : times) {
+                writer.Value(value);
+            }
+            writer.EndArray();
+        }
+        checksum += out.str().size();
+    }));
+
+    std::cout << "checksum: "sv << checksum << '\n';
+}
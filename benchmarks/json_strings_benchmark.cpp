@@ -0,0 +1,74 @@
+#include "benchmark.h"
+#include "json.h"
+#include "json_writer.h"
+
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+
+using namespace std::literals;
+
+namespace {
+    // Документ SVG, похожий на ответ Map: count ломаных и подписей, атрибуты в кавычках, элементы с новой строки
+    std::string MakeSvg(int count) {
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<double> coordinate(30.0, 1170.0);
+
+        std::ostringstream out;
+        out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n"sv;
+        for (int i = 0; i < count; ++i) {
+            out << "  <polyline points=\""sv;
+            for (int j = 0; j < 8; ++j) {
+                out << (j > 0 ? " "sv : ""sv) << coordinate(generator) << ',' << coordinate(generator);
+            }
+            out << "\" fill=\"none\" stroke=\"green\" stroke-width=\"14\" stroke-linecap=\"round\" stroke-linejoin=\"round\"/>\n"sv;
+            out << "  <text fill=\"black\" x=\""sv << coordinate(generator) << "\" y=\""sv << coordinate(generator)
+                << "\" dx=\"7\" dy=\"-3\" font-size=\"20\" font-family=\"Verdana\">Stop "sv << i << "</text>\n"sv;
+        }
+        out << "</svg>"sv;
+        return out.str();
+    }
+}
+
+// Экранирование и разбор длинных строк в слое JSON: ответы Map состоят почти целиком из документа SVG.
+// Аргументы: число маршрутов на карте (по умолчанию 20000), число ответов (по умолчанию 20) и число повторов (по умолчанию 5)
+int main(int argc, char* argv[]) {
+    const int count = argc > 1 ? std::atoi(argv[1]) : 20000;
+    const int answers = argc > 2 ? std::atoi(argv[2]) : 20;
+    const int runs = argc > 3 ? std::atoi(argv[3]) : 5;
+
+    const std::string svg = MakeSvg(count);
+    size_t checksum = 0;
+
+    std::string text;
+    benchmark::PrintResult("write_map"sv, benchmark::MeasureBest(runs, [&] {
+        std::ostringstream out;
+        {
+            json::Writer writer(out, json::Writer::Format::COMPACT);
+            writer.StartArray();
+            for (int i = 0; i < answers; ++i) {
+                writer.StartDict().Key("map"sv).Value(std::string_view(svg)).Key("request_id"sv).Value(i).EndDict();
+            }
+            writer.EndArray();
+        }
+        text = out.str();
+        checksum += text.size();
+    }));
+
+    const json::Node node(svg);
+    benchmark::PrintResult("print_map"sv, benchmark::MeasureBest(runs, [&] {
+        std::ostringstream out;
+        for (int i = 0; i < answers; ++i) {
+            json::Print(json::Document(node), out);
+        }
+        checksum += out.str().size();
+    }));
+
+    benchmark::PrintResult("load_map"sv, benchmark::MeasureBest(runs, [&] {
+        const json::Document doc = json::Load(std::string_view(text));
+        checksum += doc.GetRoot().AsArray().size();
+    }));
+
+    std::cout << "checksum: "sv << checksum << '\n';
+}
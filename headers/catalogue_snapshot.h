@@ -0,0 +1,66 @@
+#pragma once
+
+#include "transport_catalogue.h"
+
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace directory {
+
+    // Неизменяемый снимок каталога. Доступны только константные методы,
+    // поэтому снимок можно читать из любого числа потоков без блокировок.
+    using CatalogueSnapshot = std::shared_ptr<const TransportCatalogue>;
+
+    // Заморозка загруженного каталога в снимок
+    CatalogueSnapshot MakeSnapshot(TransportCatalogue&& catalogue);
+
+    // Текущее опубликованное неизменяемое состояние.
+    // Читатель берёт указатель на состояние и работает с ним сколько нужно: старое состояние живёт, пока на него есть ссылки.
+    // Обновление собирает новое состояние рядом и публикует его атомарной заменой указателя, читатели при этом не ждут
+    // и не видят частично изменённого состояния.
+    template <typename State>
+    class SnapshotHolder {
+    public:
+        SnapshotHolder() = default;
+        explicit SnapshotHolder(std::shared_ptr<const State> state);
+
+        std::shared_ptr<const State> Get() const;
+
+        void Publish(std::shared_ptr<const State> state);
+
+        // Изменение копии текущего состояния и её публикация. Если updater бросил исключение, текущее состояние не меняется.
+        // Писатели выполняются по очереди, чтобы не потерять изменения друг друга
+        template <typename Updater>
+        void Update(Updater&& updater);
+
+    private:
+        std::shared_ptr<const State> state_;
+        std::mutex update_mutex_;
+    };
+
+    template <typename State>
+    SnapshotHolder<State>::SnapshotHolder(std::shared_ptr<const State> state)
+        : state_(std::move(state)) {
+    }
+
+    template <typename State>
+    std::shared_ptr<const State> SnapshotHolder<State>::Get() const {
+        return std::atomic_load(&state_);
+    }
+
+    template <typename State>
+    void SnapshotHolder<State>::Publish(std::shared_ptr<const State> state) {
+        std::atomic_store(&state_, std::move(state));
+    }
+
+    template <typename State>
+    template <typename Updater>
+    void SnapshotHolder<State>::Update(Updater&& updater) {
+        std::lock_guard guard(update_mutex_);
+        const std::shared_ptr<const State> current = Get();
+        auto state = current ? std::make_shared<State>(*current) : std::make_shared<State>();
+        std::forward<Updater>(updater)(*state);
+        Publish(std::move(state));
+    }
+}
@@ -2,6 +2,7 @@
 
 #include "geo.h"
 
+#include <optional>
 #include <string_view>
 #include <string>
 #include <unordered_map>
@@ -9,46 +10,45 @@
 
 namespace directory {
 
+    //Названия остановок и автобусов хранятся в пуле строк каталога
     struct Stop {
-        std::string station_name;
+        std::string_view station_name;
         ::geo::Coordinates coordinates;
+        ::geo::PreparedCoordinates prepared_coordinates;
+        size_t id = 0; //номер остановки в порядке добавления
+        bool is_removed = false; //остановка удалена при изменении базы, номер остаётся за ней
 
-        Stop(std::string_view p_station_name, ::geo::Coordinates p_coordinates)
-            : station_name({ p_station_name.begin(), p_station_name.end() }),
-            coordinates(p_coordinates) {
+        Stop(std::string_view p_station_name, ::geo::Coordinates p_coordinates, size_t p_id)
+            : station_name(p_station_name),
+            coordinates(p_coordinates),
+            prepared_coordinates(::geo::PrepareCoordinates(p_coordinates)),
+            id(p_id) {
         }
+    };
 
-        Stop(Stop&& other) noexcept
-            : station_name(other.station_name),
-            coordinates(other.coordinates) {
-        }
-        Stop& operator=(const Stop& other) = default;
+    //Посчитанная статистика маршрута
+    struct BusStat {
+        size_t stops_on_route = 0;
+        size_t unique_stops = 0;
+        uint64_t route_length = 0;
+        double curvature = 0;
     };
 
     struct Bus {
-        std::string bus_name;
+        std::string_view bus_name;
         size_t stops_on_route;
         size_t unique_stops;
         uint64_t route_length = 0;
         double curvature = 0;
         bool is_roundtrip = false;
+        bool is_removed = false; //автобус удалён при изменении базы
 
-        Bus(std::string p_bus_name, size_t p_stops_on_route, size_t p_unique_stops, bool p_is_roundtrip)
-            : bus_name(std::move(p_bus_name)),
+        Bus(std::string_view p_bus_name, size_t p_stops_on_route, size_t p_unique_stops, bool p_is_roundtrip)
+            : bus_name(p_bus_name),
             stops_on_route(p_stops_on_route),
             unique_stops(p_unique_stops),
             is_roundtrip(p_is_roundtrip) {
         }
-
-        Bus(Bus&& other) noexcept
-            : bus_name(other.bus_name),
-            stops_on_route(other.stops_on_route),
-            unique_stops(other.unique_stops),
-            route_length(other.route_length),
-            curvature(other.curvature),
-            is_roundtrip(other.is_roundtrip) {
-        }
-        Bus& operator=(const Bus& other) = default;
     };
 
     namespace json_detail {
@@ -65,12 +65,31 @@ namespace directory {
             std::unordered_map<std::string, uint64_t, std::hash<std::string_view>> distance_to_stop;
         };
 
+        //Изменение загруженной базы: добавление, изменение или удаление ("action": "remove")
+        struct QueryUpdate {
+            std::string type; //Stop or Bus or Distance
+            bool is_remove = false;
+            QueryStop stop; //for Stop
+            bool has_coordinates = false; //for Stop, без координат меняются только дистанции
+            QueryBus bus; //for Bus
+            std::string from; //for Distance
+            std::string to; //for Distance
+            uint64_t distance = 0; //for Distance
+        };
+
         struct QueryStat {
             int id = 0;
             std::string type; //Route or Stop or Bus
             std::string name; //for Stop and Bus
             std::string from; //for Route
             std::string to; //for Route
+            std::optional<::geo::Coordinates> from_point; //for Route из произвольной точки
+            std::optional<::geo::Coordinates> to_point; //for Route в произвольную точку
+            ::geo::Coordinates coordinates; //for NearestStops
+            size_t count = 0; //for NearestStops и StopSearch, 0 - без ограничения
+            double radius = 0; //for NearestStops, 0 - без ограничения
+            std::string prefix; //for StopSearch
+            std::vector<std::string> names; //for CommonBuses (остановки) и CommonStops (автобусы)
         };
     }
 }
\ No newline at end of file
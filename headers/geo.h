@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 namespace geo {
 
     struct Coordinates {
@@ -7,6 +9,20 @@ namespace geo {
         double lng = 0; // Долгота
     };
 
+    // Заранее посчитанные тригонометрические величины координаты,
+    // чтобы не вычислять sin/cos широты при каждом расчёте расстояния
+    struct PreparedCoordinates {
+        double sin_lat = 0;
+        double cos_lat = 0;
+        double lng_rad = 0; // Долгота в радианах
+    };
+
+    PreparedCoordinates PrepareCoordinates(Coordinates coordinates);
+
     double ComputeDistance(Coordinates from, Coordinates to);
+    double ComputeDistance(const PreparedCoordinates& from, const PreparedCoordinates& to);
+
+    // Длина ломаной, проходящей через точки по порядку, за один проход по массиву
+    double ComputeRouteDistance(const std::vector<PreparedCoordinates>& points);
 
 }  // namespace geo
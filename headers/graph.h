@@ -2,6 +2,7 @@
 
 #include "ranges.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <vector>
 
@@ -27,13 +28,16 @@ namespace graph {
         DirectedWeightedGraph() = default;
         explicit DirectedWeightedGraph(size_t vertex_count);
         EdgeId AddEdge(const Edge<Weight>& edge);
+        VertexId AddVertex();
+        // Ребро исключается из списка исходящих рёбер вершины, номера остальных рёбер не меняются
+        void RemoveEdge(EdgeId edge_id);
 
         size_t GetVertexCount() const;
         size_t GetEdgeCount() const;
         const Edge<Weight>& GetEdge(EdgeId edge_id) const;
         IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
-        std::vector<Edge<Weight>> GetEdges();
+        std::vector<Edge<Weight>> GetEdges() const;
 
     private:
         std::vector<Edge<Weight>> edges_;
@@ -53,6 +57,18 @@ namespace graph {
         return id;
     }
 
+    template <typename Weight>
+    VertexId DirectedWeightedGraph<Weight>::AddVertex() {
+        incidence_lists_.emplace_back();
+        return incidence_lists_.size() - 1;
+    }
+
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::RemoveEdge(EdgeId edge_id) {
+        auto& incidence_list = incidence_lists_.at(edges_.at(edge_id).from);
+        incidence_list.erase(std::remove(incidence_list.begin(), incidence_list.end(), edge_id), incidence_list.end());
+    }
+
     template <typename Weight>
     size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
         return incidence_lists_.size();
@@ -75,7 +91,7 @@ namespace graph {
     }
 
     template <typename Weight>
-    std::vector<Edge<Weight>> DirectedWeightedGraph<Weight>::GetEdges() {
+    std::vector<Edge<Weight>> DirectedWeightedGraph<Weight>::GetEdges() const {
         return edges_;
     }
 }  // namespace graph
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace incidence_index {
+
+    // Сжатое множество номеров в духе Roaring bitmap.
+    // Номера делятся на блоки по старшим 16 битам. В блоке с небольшим числом номеров хранится
+    // отсортированный массив младших 16 бит, в плотном блоке - битовая карта из 1024 слов по 64 бита.
+    class CompressedBitset {
+    public:
+        CompressedBitset() = default;
+
+        // Построение по возрастающей последовательности номеров без повторов
+        explicit CompressedBitset(const std::vector<uint32_t>& sorted_values);
+
+        bool Contains(uint32_t value) const;
+        size_t GetCount() const;
+        bool IsEmpty() const;
+        std::vector<uint32_t> GetValues() const;
+
+        // Пересечение: битовые карты объединяются пословно, массивы - слиянием
+        CompressedBitset Intersect(const CompressedBitset& other) const;
+
+    private:
+        struct Container {
+            uint16_t key = 0;
+            std::vector<uint16_t> array;   // отсортированные младшие 16 бит, если блок разреженный
+            std::vector<uint64_t> bitmap;  // битовая карта, если блок плотный
+            uint32_t count = 0;
+
+            bool IsBitmap() const;
+            bool Contains(uint16_t low) const;
+        };
+
+        // Начиная с этого числа номеров блок хранится битовой картой: она занимает столько же памяти, сколько массив
+        static constexpr uint32_t ARRAY_LIMIT = 4096;
+        static constexpr size_t BITMAP_WORDS = 1024;
+
+        std::vector<Container> containers_; // по возрастанию key
+
+        static Container IntersectContainers(const Container& lhs, const Container& rhs);
+        static void Optimize(Container& container);
+        const Container* FindContainer(uint16_t key) const;
+    };
+
+    // Индекс инцидентности остановок и автобусов в обе стороны.
+    // Остановки и автобусы задаются номерами в порядке добавления в каталог.
+    class IncidenceIndex {
+    public:
+        IncidenceIndex() = default;
+
+        // stop_bus_ids[stop] - отсортированные номера автобусов через остановку
+        explicit IncidenceIndex(const std::vector<std::vector<uint32_t>>& stop_bus_ids);
+
+        // Автобусы, проходящие через все перечисленные остановки
+        std::vector<uint32_t> GetCommonBuses(const std::vector<size_t>& stop_ids) const;
+
+        // Остановки, через которые проходят все перечисленные автобусы
+        std::vector<uint32_t> GetCommonStops(const std::vector<size_t>& bus_ids) const;
+
+    private:
+        std::vector<CompressedBitset> stop_to_buses_;
+        std::vector<CompressedBitset> bus_to_stops_;
+
+        static std::vector<uint32_t> IntersectAll(const std::vector<CompressedBitset>& sets, const std::vector<size_t>& ids);
+    };
+}
@@ -1,16 +1,58 @@
 #pragma once
 
+#include <cstddef>
 #include <iostream>
-#include <map>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
 namespace json {
 
     class Node;
-    using Dict = std::map<std::string, Node>;
-    using Array = std::vector<Node>;
+    // Массивы и словари берут память у memory_resource: узлы документа, разобранного json::Load,
+    // лежат в общей области документа и освобождаются вместе с ним. Копия узла использует память по умолчанию
+    using Array = std::pmr::vector<Node>;
+
+    // Словарь в виде вектора пар, отсортированного по ключу: пары лежат подряд, поиск - двоичный.
+    // Повторяет нужную часть интерфейса std::map, при повторной вставке ключа остаётся первое значение
+    class Dict {
+    public:
+        using value_type = std::pair<std::string, Node>;
+        using Items = std::pmr::vector<value_type>;
+        // Изменённый ключ нарушил бы порядок пар, поэтому итераторы только константные
+        using const_iterator = Items::const_iterator;
+        using iterator = const_iterator;
+
+        Dict() = default;
+        // Пары сортируются по ключу, из пар с одинаковым ключом остаётся первая
+        explicit Dict(Items items);
+
+        const_iterator begin() const;
+        const_iterator end() const;
+
+        size_t size() const;
+        bool empty() const;
+
+        const_iterator find(std::string_view key) const;
+        size_t count(std::string_view key) const;
+        // Исключение std::out_of_range, если ключа нет
+        const Node& at(std::string_view key) const;
+
+        std::pair<iterator, bool> insert(value_type item);
+        std::pair<iterator, bool> emplace(std::string key, Node value);
+
+        bool operator==(const Dict& rhs) const;
+        bool operator!=(const Dict& rhs) const;
+
+    private:
+        Items items_;
+
+        const_iterator LowerBound(std::string_view key) const;
+    };
+
     using AllType = std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string>;
 
     // Эта ошибка должна выбрасываться при ошибках парсинга JSON
@@ -50,12 +92,14 @@ namespace json {
         bool operator==(const Node& rhs) const;
         bool operator!=(const Node& rhs) const;
 
-        variant GetValue() const;
+        const Value& GetValue() const;
     };
 
     class Document {
     public:
         explicit Document(Node root);
+        // Узлы root выделены из arena, она живёт, пока жив документ
+        Document(std::unique_ptr<std::pmr::monotonic_buffer_resource> arena, Node root);
 
         const Node& GetRoot() const;
 
@@ -63,6 +107,7 @@ namespace json {
         bool operator!=(const Document& rhs) const;
 
     private:
+        std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
         Node root_;
     };
 
@@ -93,9 +138,24 @@ namespace json {
         int indent = 0;
     };
 
+    // Разбор всего потока: поток читается в память целиком и разбирается как буфер
     Document Load(std::istream& input);
+    Document Load(std::string_view text);
+
+    // Чтение потока в память целиком
+    std::string ReadAll(std::istream& input);
 
     void Print(const Document& doc, std::ostream& output);
     void PrintNode(const Node& node, const RenderContext& ctx);
 
+    // Вывод чисел через to_chars в том же виде, что и operator<< потока:
+    // double - как %g с точностью потока, если у потока не задан fixed или scientific
+    void PrintNumber(int value, std::ostream& out);
+    void PrintNumber(double value, std::ostream& out);
+
+    // Запись числа в [begin, end) в том же виде, что и PrintNumber. Возвращается конец записанного,
+    // для double - nullptr, если у потока format особый формат и число должен выводить сам поток
+    char* FormatNumber(int value, char* begin, char* end);
+    char* FormatNumber(double value, const std::ios_base& format, char* begin, char* end);
+
 }  // namespace json
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "json.h"
+
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+    // Потоковый разбор JSON из буфера в памяти: значения читаются по одному событию без построения дерева.
+    // Строки без escape-последовательностей возвращаются как string_view в исходный буфер,
+    // буфер должен жить, пока используются полученные строки.
+    class Parser {
+    public:
+        enum class Event {
+            START_DICT,
+            END_DICT,
+            START_ARRAY,
+            END_ARRAY,
+            KEY,
+            STRING,
+            INT,
+            DOUBLE,
+            BOOL,
+            NULL_VALUE,
+            END // корневое значение прочитано
+        };
+
+        explicit Parser(std::string_view text);
+
+        // Разбор на месте: строки с escape-последовательностями декодируются прямо в text,
+        // поэтому все полученные строки остаются действительными, пока жив text
+        explicit Parser(std::string& text);
+
+        Event Next();
+
+        // Значение последнего события KEY или STRING.
+        // Строка с escape-последовательностями декодируется во внутренний буфер и действительна до следующего вызова Next,
+        // если разбор идёт не на месте
+        std::string_view GetString() const;
+        int GetInt() const;
+        // Для событий INT и DOUBLE
+        double GetDouble() const;
+        bool GetBool() const;
+
+        // Пропуск значения, первое событие которого уже получено: для START_DICT и START_ARRAY - до конца контейнера
+        void Skip(Event event);
+        // Пропуск контейнера, событие START_DICT или START_ARRAY которого уже получено.
+        // Возвращается исходный текст контейнера вместе со скобками, поэтому при разборе на месте не применяется
+        std::string_view SkipRaw(Event event);
+
+    private:
+        enum class State {
+            VALUE, // ожидается значение
+            FIRST, // контейнер только что открыт
+            NEXT   // значение прочитано, ожидается запятая или конец контейнера
+        };
+
+        const char* pos_;
+        const char* end_;
+        char* writable_begin_ = nullptr; // начало буфера при разборе на месте
+        const char* begin_ = nullptr;
+        std::vector<char> stack_;
+        State state_ = State::VALUE;
+
+        std::string_view string_;
+        std::string unescaped_;
+        int int_value_ = 0;
+        double double_value_ = 0;
+        bool bool_value_ = false;
+
+        void SkipSpaces();
+        char Peek() const;
+        Event ReadValue();
+        Event ReadKey();
+        Event CloseContainer(char close);
+        void ReadString();
+        Event ReadNumber();
+        void ReadLiteral(std::string_view literal);
+    };
+
+    // Построение дерева для значения, первое событие которого уже получено.
+    // Память для массивов и словарей берётся у resource
+    Node LoadNode(Parser& parser, Parser::Event event, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // То же для дерева, которое живёт в области памяти документа: массивы и словари создаются сразу нужного размера
+    Node LoadTree(Parser& parser, Parser::Event event, std::pmr::memory_resource* resource);
+
+}  // namespace json
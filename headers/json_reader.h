@@ -2,13 +2,17 @@
 
 #include "domain.h"
 #include "json.h"
-#include "json_builder.h"
+#include "json_parser.h"
+#include "json_writer.h"
+#include "profiler.h"
 #include "request_handler.h"
 #include "serialization.h"
+#include "thread_pool.h"
 #include "transport_catalogue.h"
 #include "transport_router.h"
 
 #include <deque>
+#include <optional>
 #include <sstream>
 #include <vector>
 
@@ -16,26 +20,56 @@ namespace directory {
     namespace json_detail {
         class JsonReader final {
         public:
-            void ReadMakeBase(std::istream& is, ::serialization_space::SerializeVariable& serialize_variable, std::string& path);
+            //Запросы к базе читаются потоком и сразу передаются в каталог, дерево строится только для настроек.
+            //Возвращает false, если запрос не разобран, - ошибка уже выведена в stderr
+            bool ReadMakeBase(std::istream& is, ::serialization_space::SerializeVariable& serialize_variable, std::string& path, ::renderer::RequestHandler& rh);
 
-            void ReadProcessRequests(std::istream& is, std::vector<QueryStat>& stat_queries, std::string& path);
+            //stat_requests только запоминаются: они разбираются в PrintStatRequests, когда база уже загружена.
+            //Возвращает false, если запрос не разобран, - ошибка уже выведена в stderr
+            bool ReadProcessRequests(std::istream& is, std::vector<QueryUpdate>& update_queries, std::string& path);
+            //То же для уже прочитанного текста запроса, например одной строки в режиме serve
+            bool ReadProcessRequests(std::string input, std::vector<QueryUpdate>& update_queries, std::string& path);
 
-            void PrintStatRequests(::renderer::RequestHandler& rh, std::vector<QueryStat>& queries, std::ostream& os);
+            //Запросы разбираются и выполняются небольшими частями, ответы в памяти не накапливаются.
+            //Одинаковые запросы с разными id выполняются один раз, повторно выводится готовый ответ;
+            //если в начале пакета повторов почти нет, они больше не ищутся.
+            //С пулом потоков части обрабатываются в нескольких потоках, ответы выводятся в порядке запросов.
+            //Пакет отвечает по состоянию базы, взятому из rh один раз: оно только читается из всех потоков без блокировок.
+            //Если задан latency, в него записывается время выполнения и вывода каждого запроса
+            void PrintStatRequests(const ::renderer::RequestHandler& rh, std::ostream& os, ::json::Writer::Format format = ::json::Writer::Format::PRETTY,
+                ::thread_pool::ThreadPool* pool = nullptr, ::profiler::LatencyStats* latency = nullptr);
 
         private:
-            void ReadBaseRequests(const ::json::Node& request, std::vector<QueryBus>& bus_queries, std::vector<QueryStop>& stop_queries);
+            void ReadBaseRequests(::json::Parser& parser, ::renderer::RequestHandler& rh);
+            //Изменения загруженной базы в base_requests запроса process_requests
+            void ReadUpdateRequests(const ::json::Node& request, std::vector<QueryUpdate>& update_queries);
             void ReadRenderSettings(const ::json::Node& request, ::map_renderer::MapRenderer& renderer);
-            void ReadStatRequests(const ::json::Node& request, std::vector<QueryStat>& stat_queries);
-            void ReadRoutingSettings(const ::json::Node& request, std::pair<int, double>& routing_settings);
+            QueryStat ReadStatRequest(const ::json::Node& request);
+            void ReadRoutingSettings(const ::json::Node& request, std::pair<int, double>& routing_settings, double& walk_velocity);
             void ReadSerializationSettings(const ::json::Node& request, std::string& path);
 
-            void PrintBus(Bus* bus, int id, ::json::Array& out_array);
-            void PrintStop(bool contain_stop, std::set<std::string_view>& buses, int id, ::json::Array& out_array);
-            void PrintMap(svg::Document doc, int id, ::json::Array& out_array);
-            void PrintRoute(const QueryStat& query_out, ::json::Array& out_array, ::renderer::RequestHandler& rh);
-            void PrintNotFoundRoute(const QueryStat& query_out, ::json::Array& out_array);
+            void PrintStatChunks(::json::Parser& parser, const ::renderer::BaseView& view, ::json::Writer& writer,
+                std::ostream& os, ::json::Writer::Format format, ::thread_pool::ThreadPool* pool, ::profiler::LatencyStats* latency);
+            //Timer - ::profiler::RequestTimer или ::profiler::NoRequestTimer, выбирается один раз для части запросов
+            template <typename Timer>
+            void PrintStatRequest(const QueryStat& query_out, ::json::Writer& writer, const ::renderer::BaseView& view, ::profiler::LatencyStats* latency);
+
+            void PrintBus(const Bus* bus, int id, ::json::Writer& writer);
+            void PrintStop(bool contain_stop, const std::set<std::string_view>& buses, int id, ::json::Writer& writer);
+            void PrintMap(const svg::Document& doc, int id, ::json::Writer& writer);
+            void PrintRoute(const QueryStat& query_out, const ::transport_router::TransportRouter::RouteInfo& route, ::json::Writer& writer);
+            void PrintNotFound(int id, ::json::Writer& writer);
+            void PrintWalk(const ::transport_router::TransportRouter::WalkInfo& walk, ::json::Writer& writer);
+            void PrintNearestStops(const QueryStat& query_out, const std::vector<std::pair<std::string_view, double>>& stops, ::json::Writer& writer);
+            void PrintStopSearch(const QueryStat& query_out, const std::vector<std::pair<std::string_view, std::set<std::string_view>>>& stops,
+                ::json::Writer& writer);
+            void PrintCommon(const QueryStat& query_out, const std::optional<std::vector<std::string_view>>& names, ::json::Writer& writer);
 
             ::svg::Color GetColor(const ::json::Node& node);
+
+            //Входные данные process_requests и текст stat_requests в них
+            std::string input_;
+            std::string_view stat_requests_;
         };
     }
 }
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace json {
+
+    // Поиск первого символа, который требует особой обработки в строке JSON: '"', '\\', '\n' или '\r'.
+    // Если таких символов нет, возвращается end. При поддержке SSE2 строка проверяется по 16 байт за раз
+    const char* FindSpecialChar(const char* begin, const char* end);
+
+    // Содержимое строки JSON без кавычек: '"' и '\\' экранируются, переводы строк заменяются на \n и \r.
+    // Участки без особых символов добавляются к out целиком
+    void AppendEscaped(std::string& out, std::string_view value);
+
+    // То же для потока: вывод копится в буфере на 4 КБ на стеке и пишется в поток крупными частями,
+    // участки длиннее буфера пишутся в поток напрямую
+    void PrintEscaped(std::string_view value, std::ostream& out);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+    // Потоковый вывод JSON без построения дерева: значения пишутся в буфер, который крупными кусками
+    // передаётся в поток. В формате PRETTY вывод совпадает с json::Print (отступ 4 пробела),
+    // в формате COMPACT пробелы и переводы строк не выводятся.
+    // Ключи словаря выводятся в порядке вызовов Key, для совпадения с json::Print их нужно задавать по алфавиту.
+    class Writer final {
+    public:
+        enum class Format {
+            PRETTY,
+            COMPACT
+        };
+
+        // indent - отступ, на котором начинается выводимое значение
+        explicit Writer(std::ostream& out, Format format = Format::PRETTY, int indent = 0);
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+        // Остаток буфера выводится в поток
+        ~Writer();
+
+        Writer& Key(std::string_view key);
+        Writer& Value(std::nullptr_t);
+        Writer& Value(bool value);
+        Writer& Value(int value);
+        Writer& Value(double value);
+        Writer& Value(std::string_view value);
+        Writer& Value(const char* value);
+        Writer& StartDict();
+        Writer& StartArray();
+        Writer& EndDict();
+        Writer& EndArray();
+
+        // Значение, уже выведенное отдельным Writer в том же формате с отступом GetValueIndent()
+        Writer& RawValue(std::string_view json);
+
+        // Глубина открытых контейнеров
+        size_t GetDepth() const;
+
+        // Отступ, с которого начнётся следующее значение
+        int GetValueIndent() const;
+
+        // Вывод накопленного в поток
+        void Flush();
+
+    private:
+        struct Container {
+            bool is_dict;
+            bool is_empty = true;
+        };
+
+        std::ostream& out_;
+        const Format format_;
+        const int indent_;
+        std::string buffer_;
+        std::vector<Container> stack_;
+        bool is_key_written_ = false;
+        bool is_root_written_ = false;
+
+        void BeforeValue();
+        void EndContainer(bool is_dict);
+        void WriteNewLine(size_t depth);
+        void WriteString(std::string_view value);
+        void FlushIfFull();
+    };
+}
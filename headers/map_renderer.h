@@ -100,7 +100,7 @@ namespace map_renderer {
 
     class DrawRoute {
     public:
-        DrawRoute(std::deque<std::pair<::directory::Bus*, std::vector<std::string_view>>>& buses_with_stops, std::set<std::string>& all_stops,
+        DrawRoute(std::deque<std::pair<const ::directory::Bus*, std::vector<std::string_view>>>& buses_with_stops, std::set<std::string>& all_stops,
             std::deque<::geo::Coordinates>& coordinates, const map_renderer::MapRenderer& renderer, std::unordered_map<std::string_view,
             ::geo::Coordinates>& stops_with_coordinates);
 
@@ -111,7 +111,7 @@ namespace map_renderer {
 
     private:
         std::set<std::string>& all_stops_;
-        std::deque<std::pair<::directory::Bus*, std::vector<std::string_view>>>& buses_with_stops_;
+        std::deque<std::pair<const ::directory::Bus*, std::vector<std::string_view>>>& buses_with_stops_;
         const ::map_renderer::MapRenderer& renderer_;
         SphereProjector sphere_projector_;
         std::unordered_map<std::string_view, ::geo::Coordinates>& stops_with_coordinates_;
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Дерево кратчайших путей из нескольких источников (алгоритм Дейкстры).
+    // Каждому источнику можно задать начальный вес, например время, чтобы до него дойти.
+    // Если заданы целевые вершины, поиск останавливается, как только все они достигнуты.
+    template <typename Weight>
+    class ShortestPathTree {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        ShortestPathTree(const Graph& graph, const std::vector<std::pair<VertexId, Weight>>& sources,
+                         const std::vector<VertexId>& targets = {});
+
+        bool IsReached(VertexId vertex) const;
+        Weight GetWeight(VertexId vertex) const;
+
+        // Источник, из которого построен путь до вершины
+        VertexId GetSource(VertexId vertex) const;
+
+        // Рёбра пути от источника до вершины по порядку
+        std::vector<EdgeId> GetEdges(VertexId vertex) const;
+
+    private:
+        struct VertexData {
+            std::optional<Weight> weight;
+            std::optional<EdgeId> prev_edge;
+            VertexId source = 0;
+        };
+
+        static constexpr Weight ZERO_WEIGHT{};
+        const Graph& graph_;
+        std::vector<VertexData> vertices_;
+    };
+
+    template <typename Weight>
+    ShortestPathTree<Weight>::ShortestPathTree(const Graph& graph, const std::vector<std::pair<VertexId, Weight>>& sources,
+                                               const std::vector<VertexId>& targets)
+        : graph_(graph)
+        , vertices_(graph.GetVertexCount())
+    {
+        using QueueItem = std::pair<Weight, VertexId>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+
+        for (const auto& [vertex, weight] : sources) {
+            auto& data = vertices_.at(vertex);
+            if (!data.weight || weight < *data.weight) {
+                data = VertexData{ weight, std::nullopt, vertex };
+                queue.push({ weight, vertex });
+            }
+        }
+
+        std::vector<bool> is_target(targets.empty() ? 0 : vertices_.size(), false);
+        for (VertexId target : targets) {
+            is_target.at(target) = true;
+        }
+        size_t targets_left = std::count(is_target.begin(), is_target.end(), true);
+
+        std::vector<bool> settled(vertices_.size(), false);
+        while (!queue.empty()) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (settled[vertex]) {
+                continue;
+            }
+            settled[vertex] = true;
+
+            if (!is_target.empty() && is_target[vertex] && --targets_left == 0) {
+                break;
+            }
+
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                if (edge.weight < ZERO_WEIGHT) {
+                    throw std::domain_error("Edges' weights should be non-negative");
+                }
+
+                auto& data = vertices_[edge.to];
+                const Weight candidate_weight = weight + edge.weight;
+                if (!data.weight || candidate_weight < *data.weight) {
+                    data = VertexData{ candidate_weight, edge_id, vertices_[vertex].source };
+                    queue.push({ candidate_weight, edge.to });
+                }
+            }
+        }
+    }
+
+    template <typename Weight>
+    bool ShortestPathTree<Weight>::IsReached(VertexId vertex) const {
+        return vertices_.at(vertex).weight.has_value();
+    }
+
+    template <typename Weight>
+    Weight ShortestPathTree<Weight>::GetWeight(VertexId vertex) const {
+        return vertices_.at(vertex).weight.value();
+    }
+
+    template <typename Weight>
+    VertexId ShortestPathTree<Weight>::GetSource(VertexId vertex) const {
+        return vertices_.at(vertex).source;
+    }
+
+    template <typename Weight>
+    std::vector<EdgeId> ShortestPathTree<Weight>::GetEdges(VertexId vertex) const {
+        std::vector<EdgeId> edges;
+        for (std::optional<EdgeId> edge_id = vertices_.at(vertex).prev_edge;
+             edge_id;
+             edge_id = vertices_[graph_.GetEdge(*edge_id).from].prev_edge)
+        {
+            edges.push_back(*edge_id);
+        }
+        std::reverse(edges.begin(), edges.end());
+
+        return edges;
+    }
+
+}  // namespace graph
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace profiler {
+
+    // Пиковый объём занятой процессом памяти в КБ, 0 - если неизвестен
+    size_t GetPeakRss();
+
+    // Время работы по этапам программы. Этапы с одинаковым названием, например по одному
+    // на каждый запрос в режиме serve, складываются в один
+    class PhaseProfiler {
+    public:
+        struct Phase {
+            std::string name;
+            size_t count = 0;
+            std::chrono::nanoseconds duration{ 0 };
+            size_t peak_rss = 0; // пиковая память в КБ по окончании этапа
+        };
+
+        void AddPhase(std::string_view name, std::chrono::nanoseconds duration);
+
+        const std::vector<Phase>& GetPhases() const;
+
+        // Отчёт в формате JSON одной строкой: этапы в порядке первого появления и общее время от создания
+        void Print(std::string_view mode, std::ostream& out) const;
+
+    private:
+        const std::chrono::steady_clock::time_point start_ = std::chrono::steady_clock::now();
+        std::vector<Phase> phases_;
+    };
+
+    // Замер этапа от создания объекта до его разрушения
+    class ScopedPhase {
+    public:
+        ScopedPhase(PhaseProfiler& profiler, std::string_view name);
+        ScopedPhase(const ScopedPhase&) = delete;
+        ScopedPhase& operator=(const ScopedPhase&) = delete;
+        ~ScopedPhase();
+
+    private:
+        PhaseProfiler& profiler_;
+        std::string_view name_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    // Гистограмма длительностей с логарифмически-линейными корзинами, как в HdrHistogram:
+    // каждый интервал [2^k, 2^(k+1)) нс делится на SUB_BUCKETS равных корзин,
+    // поэтому перцентили известны с относительной погрешностью не больше 1/SUB_BUCKETS
+    class LatencyHistogram {
+    public:
+        static const size_t SUB_BUCKET_BITS = 5;
+        static const size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+
+        void Record(std::chrono::nanoseconds duration);
+        void Merge(const LatencyHistogram& other);
+
+        uint64_t GetCount() const;
+        std::chrono::nanoseconds GetMax() const;
+
+        // Длительность, не меньше которой quantile записанных значений (верхняя граница корзины)
+        std::chrono::nanoseconds GetPercentile(double quantile) const;
+
+    private:
+        std::vector<uint64_t> counts_; // пуст, пока ничего не записано
+        uint64_t count_ = 0;
+        uint64_t max_ = 0;
+    };
+
+    // Гистограммы времени выполнения и вывода ответа по типам запросов
+    class LatencyStats {
+    public:
+        LatencyStats();
+        LatencyStats(const LatencyStats&) = delete;
+        LatencyStats& operator=(const LatencyStats&) = delete;
+        ~LatencyStats();
+
+        void Record(std::string_view type, std::chrono::nanoseconds execution, std::chrono::nanoseconds serialization);
+        void Merge(const LatencyStats& other);
+
+        // Отчёт в формате JSON одной строкой: число запросов, p50, p90, p99 и максимум в нс по каждому типу
+        void Print(std::ostream& out) const;
+
+    private:
+        struct TypeStats {
+            std::string type;
+            LatencyHistogram execution;
+            LatencyHistogram serialization;
+        };
+
+        std::vector<TypeStats> types_;
+
+        TypeStats& GetTypeStats(std::string_view type);
+    };
+
+    // Замер одного запроса: от создания до MarkExecuted - выполнение, от MarkExecuted до Finish - вывод ответа.
+    // Без stats ничего не замеряет, поэтому может оставаться в коде постоянно
+    class RequestTimer {
+    public:
+        RequestTimer(LatencyStats* stats, std::string_view type);
+
+        void MarkExecuted();
+
+        // Запись в stats, если запрос выполнен. Время выполнения можно задать явно,
+        // например долю общего поиска для группы запросов
+        void Finish();
+        void Finish(std::chrono::nanoseconds execution);
+
+    private:
+        LatencyStats* stats_;
+        std::string_view type_;
+        std::chrono::steady_clock::time_point start_;
+        std::chrono::steady_clock::time_point executed_;
+    };
+
+    // RequestTimer для работы без замеров: вызовы пустые и встраиваются, в коде запросов не остаётся даже проверок stats
+    class NoRequestTimer {
+    public:
+        NoRequestTimer(LatencyStats*, std::string_view) {}
+
+        void MarkExecuted() {}
+
+        void Finish() {}
+        void Finish(std::chrono::nanoseconds) {}
+    };
+}
@@ -1,16 +1,23 @@
 #pragma once
 
+#include "catalogue_snapshot.h"
 #include "geo.h"
+#include "incidence_index.h"
 #include "domain.h"
 #include "map_renderer.h"
 #include "router.h"
 #include "serialization.h"
+#include "spatial_index.h"
+#include "stop_search.h"
 #include "svg.h"
 #include "transport_catalogue.h"
 #include "transport_router.h"
 
+#include <algorithm>
 #include <deque>
+#include <memory>
 #include <optional>
+#include <stdexcept>
 #include <string>
 #include <tuple>
 #include <unordered_map>
@@ -19,20 +26,81 @@
 
 namespace renderer {
 
+    //Граф маршрутов и построенный по нему Router. Router ссылается на граф, поэтому они создаются и хранятся вместе
+    struct RoutingState {
+        ::transport_router::TransportRouter tr_rout;
+        //Нет, если граф менялся после загрузки базы: тогда маршруты ищутся поиском по графу
+        std::optional<::graph::Router<double>> router;
+    };
+
+    //Всё, что читают ответы на запросы: каталог, граф маршрутов, индексы и скорость пешехода.
+    //Опубликованное состояние не меняется. Части, которые изменение базы не затронуло, общие у старого и нового состояния
+    struct BaseState {
+        //Владеет каталогом; пуст, если каталог заполняется при создании базы и принадлежит вызывающему
+        ::directory::CatalogueSnapshot snapshot;
+        const ::directory::TransportCatalogue* db = nullptr;
+        std::shared_ptr<const RoutingState> routing;
+        std::shared_ptr<const ::spatial_index::SpatialIndex> spatial_index;
+        //Остановки, через которые не ходит ни один автобус: у них нет вершины в графе (или рёбер из неё),
+        //поэтому маршрут из точки с них не начинается и ими не заканчивается
+        std::vector<bool> unserved_stops;
+        std::shared_ptr<const ::stop_search::StopNameIndex> stop_search;
+        std::shared_ptr<const ::incidence_index::IncidenceIndex> incidence_index;
+        double walk_velocity = 0;
+    };
+
+    //Ответы на запросы по одному состоянию базы. Состояние не меняется, пока на него есть ссылка,
+    //поэтому методы вызываются из любого числа потоков без блокировок
+    class BaseView {
+    public:
+        BaseView(std::shared_ptr<const BaseState> state, const map_renderer::MapRenderer& renderer);
+
+        const ::directory::Bus* GetInfoAboutRoute(const std::string_view& bus_name) const;
+
+        std::tuple<bool, std::set<std::string_view>> GetBusesForStop(const std::string_view& stop_name) const;
+
+        svg::Document RenderMap() const;
+
+        ::transport_router::TransportRouter::RouteInfo GetRouteForQuery(const ::directory::json_detail::QueryStat& query) const;
+
+        //Маршруты для запросов с одинаковым началом (from и from_point): запросы, которым нужен поиск по графу,
+        //обслуживаются одним поиском. Ответы совпадают с GetRouteForQuery
+        std::vector<::transport_router::TransportRouter::RouteInfo> GetRoutesForQueries(const std::vector<const ::directory::json_detail::QueryStat*>& queries) const;
+
+        //Ближайшие к точке остановки с расстоянием до них в метрах
+        std::vector<std::pair<std::string_view, double>> GetNearestStops(const ::directory::json_detail::QueryStat& query) const;
+
+        //Остановки, название которых начинается с префикса, и автобусы через них
+        std::vector<std::pair<std::string_view, std::set<std::string_view>>> GetStopsByPrefix(const ::directory::json_detail::QueryStat& query) const;
+
+        //Автобусы через все остановки запроса (остановки через все автобусы) по алфавиту.
+        //nullopt - если какая-то из остановок (автобусов) не найдена
+        std::optional<std::vector<std::string_view>> GetCommonBuses(const ::directory::json_detail::QueryStat& query) const;
+        std::optional<std::vector<std::string_view>> GetCommonStops(const ::directory::json_detail::QueryStat& query) const;
+
+    private:
+        std::shared_ptr<const BaseState> state_;
+        const map_renderer::MapRenderer& renderer_;
+
+        //Остановки, с которых может начаться (которыми может закончиться) маршрут, и время пешком до них
+        ::transport_router::TransportRouter::StopsWithWalkTime GetRouteEnds(const std::string& stop, const std::optional<::geo::Coordinates>& point) const;
+    };
+
     // Класс RequestHandler играет роль Фасада, упрощающего взаимодействие JSON reader-а
     // с другими подсистемами приложения.
     // См. паттерн проектирования Фасад: https://ru.wikipedia.org/wiki/Фасад_(шаблон_проектирования)
+    // Состояние базы публикуется целиком через SnapshotHolder: каждое изменение собирает новое состояние рядом
+    // и подменяет текущее одним шагом, читатели работают со своей копией указателя (GetView)
     class RequestHandler {
     public:
+        //Заполнение каталога из запросов к базе
         RequestHandler(::directory::TransportCatalogue& db, const map_renderer::MapRenderer& renderer, const std::pair<int, double>& routing_settings);
+        //Работа с неизменяемым снимком каталога только на чтение
+        RequestHandler(::directory::CatalogueSnapshot snapshot, const map_renderer::MapRenderer& renderer, const std::pair<int, double>& routing_settings);
 
-        ::directory::Bus* GetInfoAboutRoute(const std::string_view& bus_name);
-
-        std::tuple<bool, std::set<std::string_view>> GetBusesForStop(const std::string_view& stop_name);
-
-        svg::Document RenderMap() const;
-
-        ::transport_router::TransportRouter::RouteInfo GetRouteForQuery(const ::directory::json_detail::QueryStat& query);
+        //Текущее состояние базы. Пакет запросов берёт его один раз и отвечает по нему до конца,
+        //даже если за это время опубликовано новое
+        BaseView GetView() const;
 
         //void SetTransportRouter();
 
@@ -48,18 +116,41 @@ namespace renderer {
 
         void SetRouterWithNewGraph();
 
-        void GetVariableForGraph(std::vector <::graph::Edge<double>>& edges, ::graph::VertexId& vertex_count);
-        void GetVariableTransportRouter(::graph::VertexId& current_id, std::deque<transport_router::TransportRouter::Ids>& id_s_, std::map<::graph::EdgeId, transport_router::TransportRouter::EdgeInfo>& edges_id_);
+        void GetVariableForGraph(std::vector <::graph::Edge<double>>& edges, ::graph::VertexId& vertex_count) const;
+        void GetVariableTransportRouter(::graph::VertexId& current_id, std::deque<transport_router::TransportRouter::Ids>& id_s_, std::map<::graph::EdgeId, transport_router::TransportRouter::EdgeInfo>& edges_id_) const;
+
+        //Заполнение каталога при создании базы, по мере чтения base_requests
+        void AddStop(std::string_view name, ::geo::Coordinates coordinates);
+        void AddDistance(std::string_view from, std::string_view to, uint64_t distance);
+        void AddBus(std::string_view name, const std::vector<std::string_view>& stops, bool is_roundtrip);
+
+        void SetWalkVelocity(double walk_velocity);
+
+        //Применение изменений к загруженной базе. Каталог, граф и индексы нового состояния собираются на копиях,
+        //состояние публикуется только целиком; если изменение не удалось, исключение передаётся дальше, а база остаётся прежней.
+        //Перестраиваются только рёбра затронутых автобусов. Предпосчитанный Router по изменённому графу не строится:
+        //после изменения маршрутов автобусов запросы Route ищут маршрут по графу, это медленнее
+        void ApplyUpdates(const std::vector<::directory::json_detail::QueryUpdate>& queries);
 
-        void FillTransportCatalogue(::serialization_space::SerializeVariable& sv);
+        void SetSpatialIndex();
+        void RestoreSpatialIndex(::spatial_index::Grid& grid);
+        void GetVariableSpatialIndex(::spatial_index::Grid& grid) const;
+
+        void SetIncidenceIndex();
+
+        void SetStopSearch();
+        void RestoreStopSearch(::stop_search::NameIndexData& name_index);
+        void GetVariableStopSearch(::stop_search::NameIndexData& name_index) const;
 
     private:
-        ::directory::TransportCatalogue& db_;
+        ::directory::SnapshotHolder<BaseState> state_;
+        //Каталог, доступный для изменения; пуст при работе со снимком
+        ::directory::TransportCatalogue* mutable_db_ = nullptr;
         const map_renderer::MapRenderer& renderer_;
         const std::pair<int, double>& routing_settings_;
-        std::optional<::transport_router::TransportRouter> tr_rout_;
-        //::transport_router::TransportRouter tr_rout_;
-        std::optional<::graph::Router<double>> router_;
+
+        ::directory::TransportCatalogue& GetMutableCatalogue();
+        static std::vector<bool> GetUnservedStops(const ::directory::TransportCatalogue& db);
     };
 }
 
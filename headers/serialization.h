@@ -3,23 +3,28 @@
 #include "domain.h"
 #include "graph.h"
 #include "map_renderer.h"
+#include "spatial_index.h"
+#include "stop_search.h"
 #include "transport_catalogue.h"
 #include "transport_router.h"
 
 #include "graph.pb.h"
 #include "map_renderer.pb.h"
+#include "spatial_index.pb.h"
+#include "stop_search.pb.h"
 #include "svg.pb.h"
 #include "transport_catalogue.pb.h"
 #include "transport_router.pb.h"
 
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace serialization_space {
     struct SerializeVariable{
-        std::vector<::directory::json_detail::QueryBus> bus_queries;
-        std::vector<::directory::json_detail::QueryStop> stop_queries;
         std::pair<int, double> routing_settings;
+        double walk_velocity = 5.0; //скорость пешехода в км/ч, если не задана в routing_settings
         ::map_renderer::MapRenderer renderer;
         std::vector<::graph::Edge<double>> edges;
         ::graph::VertexId vertex_count;
@@ -27,13 +32,18 @@ namespace serialization_space {
         ::graph::VertexId current_id = 0;
         std::deque<::transport_router::TransportRouter::Ids> id_s_;
         std::map<::graph::EdgeId, ::transport_router::TransportRouter::EdgeInfo> edges_id_;
+
+        ::spatial_index::Grid grid;
+        ::stop_search::NameIndexData name_index;
     };
 
     class Serialization {
     public:
         Serialization(SerializeVariable& sv, std::string path);
-        void Serialize();
-        void Deserialize();
+        void Serialize(const ::directory::TransportCatalogue& catalogue);
+        //Каталог заполняется напрямую из базы, остальные данные - в SerializeVariable
+        //Если файл не открывается или не разбирается, бросает std::runtime_error
+        void Deserialize(::directory::TransportCatalogue& catalogue);
 
     private:
         std::string path_;
@@ -43,21 +53,24 @@ namespace serialization_space {
         ::svg_proto::Color GetColorProto(const ::svg::Color& color);
         ::svg::Color GetColorSvg(::svg_proto::Color color);
 
-        std::map <std::string, std::set<int32_t>> bus_edge_ids_;
-        std::string FindBusName(int32_t id);
+        std::map <std::string_view, std::set<int32_t>> bus_edge_ids_;
+        //Название автобуса для ребра графа при восстановлении, указывает в пул названий каталога
+        std::unordered_map<int32_t, std::string_view> edge_bus_names_;
 
-        void SerializeStopQueries();
-        void SerializeBusQueries();
+        void SerializeCatalogue(const ::directory::TransportCatalogue& catalogue);
         void SerializeRoutingSettings();
         void SerializeGraph();
         void SerializeMapRenderer();
         void SerializeTransportRouter();
+        void SerializeSpatialIndex();
+        void SerializeStopSearch();
 
-        void DeserializeStopQueries();
-        void DeserializeBusQueries();
+        void DeserializeCatalogue(::directory::TransportCatalogue& catalogue);
         void DeserializeRoutingSettings();
         void DeserializeGraph();
         void DeserializeMapRenderer();
-        void DeserializeTransportRouter();
+        void DeserializeTransportRouter(const ::directory::TransportCatalogue& catalogue);
+        void DeserializeSpatialIndex();
+        void DeserializeStopSearch();
     };
 }
\ No newline at end of file
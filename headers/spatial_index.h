@@ -0,0 +1,58 @@
+#pragma once
+
+#include "geo.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace spatial_index {
+
+    // Параметры равномерной сетки и раскладка остановок по ячейкам (формат CSR):
+    // остановки ячейки cell лежат в stop_ids[cell_offsets[cell] .. cell_offsets[cell + 1])
+    struct Grid {
+        double min_lat = 0;
+        double min_lng = 0;
+        double cell_lat = 1; // размер ячейки по широте в градусах
+        double cell_lng = 1; // размер ячейки по долготе в градусах
+        uint32_t rows = 0;
+        uint32_t cols = 0;
+        std::vector<uint32_t> cell_offsets;
+        std::vector<uint32_t> stop_ids;
+    };
+
+    // Пространственный индекс остановок на основе равномерной сетки.
+    // Остановка задаётся номером в порядке добавления в каталог.
+    class SpatialIndex {
+    public:
+        struct Item {
+            size_t stop_id;
+            double distance; // в метрах
+        };
+
+        // Построение индекса по координатам остановок. Остановки, отмеченные в excluded, в индекс не попадают
+        explicit SpatialIndex(const std::vector<::geo::Coordinates>& points, const std::vector<bool>& excluded = {});
+
+        // Восстановление индекса из сохранённой сетки
+        SpatialIndex(Grid grid, const std::vector<::geo::Coordinates>& points);
+
+        const Grid& GetGrid() const;
+
+        // count ближайших остановок не дальше radius метров от точки, по возрастанию расстояния.
+        // Нулевые count или radius означают отсутствие ограничения. Остановки, отмеченные в excluded, пропускаются
+        std::vector<Item> FindNearest(::geo::Coordinates point, size_t count, double radius, const std::vector<bool>& excluded = {}) const;
+
+    private:
+        Grid grid_;
+
+        // Подготовленные координаты в порядке stop_ids, чтобы ячейка читалась подряд
+        std::vector<::geo::PreparedCoordinates> points_;
+
+        // Нижняя оценка расстояния в метрах между точками, разделёнными одной ячейкой
+        double min_cell_distance_ = 0;
+
+        void PreparePoints(const std::vector<::geo::Coordinates>& points);
+        uint32_t GetRow(double lat) const;
+        uint32_t GetCol(double lng) const;
+    };
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace stop_search {
+
+    // Отсортированные нормализованные названия остановок, уложенные подряд в одну строку:
+    // i-е название - keys[offsets[i] .. offsets[i + 1]), ему соответствует остановка stop_ids[i]
+    struct NameIndexData {
+        std::string keys;
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> stop_ids;
+    };
+
+    // Приведение строки UTF-8 к виду для сравнения: латиница и кириллица в нижнем регистре, "ё" заменяется на "е".
+    // Незавершённая последовательность UTF-8 в конце строки отбрасывается.
+    std::string NormalizeName(std::string_view name);
+
+    // Индекс для поиска остановок по началу названия.
+    // Остановка задаётся номером в порядке добавления в каталог.
+    class StopNameIndex {
+    public:
+        // Построение индекса по названиям остановок. Остановки, отмеченные в excluded, в индекс не попадают
+        explicit StopNameIndex(const std::vector<std::string_view>& names, const std::vector<bool>& excluded = {});
+
+        // Восстановление индекса из сохранённых данных
+        explicit StopNameIndex(NameIndexData data);
+
+        const NameIndexData& GetData() const;
+
+        // Не более count остановок (0 - без ограничения), название которых начинается с prefix, в алфавитном порядке
+        std::vector<size_t> FindByPrefix(std::string_view prefix, size_t count) const;
+
+    private:
+        NameIndexData data_;
+
+        std::string_view GetKey(size_t index) const;
+    };
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace string_pool {
+
+    // Пул строк: одинаковые строки хранятся один раз в общих блоках памяти.
+    // Строки не удаляются и не перемещаются, поэтому string_view на них действительны всё время жизни пула.
+    class StringPool {
+    public:
+        StringPool() = default;
+        StringPool(const StringPool&) = delete;
+        StringPool& operator=(const StringPool&) = delete;
+
+        // Строка из пула с тем же содержимым, при отсутствии она копируется в пул
+        std::string_view Intern(std::string_view str);
+
+        // Число различных строк в пуле
+        size_t GetSize() const;
+
+    private:
+        static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+        std::vector<std::unique_ptr<char[]>> blocks_;
+        size_t block_used_ = BLOCK_SIZE; // занято в последнем блоке
+        std::vector<std::unique_ptr<char[]>> large_blocks_; // строки длиннее четверти блока
+        std::unordered_set<std::string_view> strings_;
+
+        char* Allocate(size_t size);
+    };
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace thread_pool {
+
+    // Пул потоков для параллельной обработки диапазона индексов с перехватом работы (work stealing).
+    // Потоки создаются один раз и ждут следующего задания, вызывающий поток тоже участвует в работе.
+    class ThreadPool final {
+    public:
+        // Диапазон индексов [begin, end), обрабатываемый за один вызов
+        using Task = std::function<void(size_t begin, size_t end)>;
+
+        // Счётчики потока за всё время работы пула
+        struct WorkerStats {
+            size_t items = 0;  // обработано индексов
+            size_t chunks = 0; // обработано частей
+            size_t steals = 0; // удачных перехватов у других потоков
+            std::chrono::nanoseconds busy{ 0 }; // время внутри task
+            std::chrono::nanoseconds idle{ 0 }; // время внутри ParallelFor без работы: поиск частей и ожидание остальных
+        };
+
+        // threads - общее число потоков с учётом вызывающего, не меньше 1
+        explicit ThreadPool(size_t threads);
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        ~ThreadPool();
+
+        size_t GetThreadCount() const;
+
+        // [0, count) делится на небольшие части, которые поровну раскладываются в очереди потоков.
+        // Поток берёт части из начала своей очереди, а когда она пуста - забирает половину частей
+        // с конца очереди другого потока. Возврат - после обработки всех частей. Исключения task должна обрабатывать сама
+        void ParallelFor(size_t count, const Task& task);
+
+        // Вызывать между заданиями. Поток 0 - вызывающий
+        const std::vector<WorkerStats>& GetStats() const;
+
+    private:
+        using Range = std::pair<size_t, size_t>;
+
+        struct WorkerQueue {
+            std::mutex mutex;
+            std::deque<Range> chunks;
+        };
+
+        std::vector<std::thread> workers_;
+        std::vector<WorkerQueue> queues_;
+        std::vector<WorkerStats> stats_;
+
+        std::mutex mutex_;
+        std::condition_variable task_ready_;
+        std::condition_variable task_done_;
+
+        const Task* task_ = nullptr;
+        // Номер задания, чтобы поток не взял одно задание дважды
+        size_t generation_ = 0;
+        size_t running_ = 0;
+        bool is_stopped_ = false;
+        // Части текущего задания, ещё не взятые на выполнение
+        std::atomic<size_t> chunks_left_ = 0;
+
+        void WorkerLoop(size_t index);
+        void RunChunks(const Task& task, size_t index);
+        bool PopChunk(size_t index, Range& chunk);
+        bool StealChunks(size_t index);
+    };
+
+    // Счётчики потоков пула в формате JSON, по объекту на поток
+    void PrintStats(const ThreadPool& pool, std::ostream& out);
+}
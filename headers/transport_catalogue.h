@@ -2,12 +2,16 @@
 
 #include "geo.h"
 #include "domain.h"
+#include "string_pool.h"
 
 #include <algorithm>
 #include <cmath>
 #include <deque>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <set>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <tuple>
@@ -25,34 +29,86 @@ namespace directory {
             }
         };
 
+        TransportCatalogue() = default;
+        //копия восстанавливается через те же методы, что и загрузка из базы, чтобы указатели вели в новый каталог.
+        //Пул названий у копий общий, поэтому ссылки на названия остаются действительными
+        TransportCatalogue(const TransportCatalogue& other);
+        TransportCatalogue(TransportCatalogue&& other) = default;
+        TransportCatalogue& operator=(const TransportCatalogue& other) = delete;
+        TransportCatalogue& operator=(TransportCatalogue&& other) = default;
+
         //добавление маршрута в базу
-        void AddRoute(std::string_view bus, std::vector<std::string>& stops, bool is_roundtrip);
+        void AddRoute(std::string_view bus, const std::vector<std::string_view>& stops, bool is_roundtrip);
+
+        //Восстановление из базы. Остановки и автобусы задаются номерами в порядке добавления
+        //восстановление маршрута с уже посчитанной статистикой, без расчёта длины и кривизны
+        void RestoreRoute(std::string_view bus, const std::vector<uint32_t>& stop_ids, bool is_roundtrip, const BusStat& stat);
+        //восстановление списка автобусов через остановку
+        void RestoreBusesForStop(size_t stop_id, const std::vector<uint32_t>& bus_ids);
+        void RestoreDistance(size_t from_id, size_t to_id, uint64_t distance);
+
+        //Изменение загруженной базы. Статистика пересчитывается только у затронутых автобусов
+        //изменение координат остановки, новая остановка добавляется
+        void UpdateStation(std::string_view stop, ::geo::Coordinates coordinates);
+        //удаление остановки, через которую не проходит ни один автобус
+        void RemoveStation(std::string_view stop);
+        //замена маршрута автобуса, новый автобус добавляется
+        void UpdateRoute(std::string_view bus, const std::vector<std::string_view>& stops, bool is_roundtrip);
+        void RemoveRoute(std::string_view bus);
+        //изменение и удаление дистанции между остановками
+        void UpdateDistance(std::string_view from, std::string_view to, uint64_t distance);
+        void RemoveDistance(std::string_view from, std::string_view to);
 
         //добавление остановки в базу
         void AddStation(std::string_view stop, ::geo::Coordinates coordinates);
-        void AddStationDistance(std::string_view stop, std::unordered_map<std::string, uint64_t, std::hash<std::string_view>>& distance_to_stop);
 
         //получение информации о маршруте
         //Bus X: R stops on route, U unique stops, L route length
-        Bus* GetInfoAboutRoute(std::string_view route);
-        std::vector<Bus*> GetBuses();
+        const Bus* GetInfoAboutRoute(std::string_view route) const;
+        std::vector<const Bus*> GetBuses() const;
 
         //метод для получения списка автобусов по остановке
-        std::tuple<bool, std::set<std::string_view>> GetBusesForStop(std::string_view station);
+        std::tuple<bool, std::set<std::string_view>> GetBusesForStop(std::string_view station) const;
 
         //задание дистанции между остановками
         void SetDistanceBetweenStops(std::string_view stop_from, std::string_view stop_to, uint64_t distance_to_stop);
         //получение дистанции между остановками
-        uint64_t GetDistanceBetweenStops(std::string_view from, std::string_view to);
+        uint64_t GetDistanceBetweenStops(std::string_view from, std::string_view to) const;
         
         //Получение списка остановок с координатами для отрисовки
-        std::unordered_map<std::string_view, ::geo::Coordinates> GetStopsWithCoordinates();
+        std::unordered_map<std::string_view, ::geo::Coordinates> GetStopsWithCoordinates() const;
 
         std::vector<std::string_view> GetStopsForBus(const std::string_view station) const;
         
-        size_t GetCountStops();
+        size_t GetCountStops() const;
+
+        //Координаты всех остановок в порядке добавления (номер остановки - индекс в векторе)
+        std::vector<::geo::Coordinates> GetAllStopCoordinates() const;
+        std::string_view GetStopName(size_t stop_id) const;
+        std::vector<std::string_view> GetAllStopNames() const;
+        //Название остановки из пула каталога, пустое для неизвестной остановки
+        std::string_view FindStopName(std::string_view stop) const;
+        //Номер остановки или автобуса по названию
+        std::optional<size_t> FindStopId(std::string_view stop) const;
+        std::optional<size_t> FindBusId(std::string_view bus) const;
+        std::string_view GetBusName(size_t bus_id) const;
+        //Отметки удалённых остановок по номерам
+        std::vector<bool> GetRemovedStops() const;
+
+        //Данные для сохранения в базу. Остановки и автобусы - в порядке добавления
+        const std::deque<Stop>& GetAllStops() const;
+        const std::deque<Bus>& GetAllBuses() const;
+        //Статистика автобусов
+        std::vector<BusStat> GetAllBusStats() const;
+        //Номера остановок маршрута автобуса
+        std::vector<uint32_t> GetStopIdsForBus(const Bus& bus) const;
+        //Номера автобусов через каждую остановку
+        std::vector<std::vector<uint32_t>> GetAllStopBusIds() const;
+        //Дистанции между остановками: номер откуда, номер куда, дистанция
+        std::vector<std::tuple<uint32_t, uint32_t, uint64_t>> GetAllDistances() const;
         
     private:
+        std::shared_ptr<::string_pool::StringPool> names_ = std::make_shared<::string_pool::StringPool>();
         std::deque<Stop> stops_;
         std::deque<Bus> buses_;
 
@@ -60,5 +116,12 @@ namespace directory {
         std::unordered_map<std::string_view, Stop*> stop_to_stop;
         std::unordered_map<std::string_view, std::vector<std::string_view>> bus_to_stops;
         std::unordered_map<std::pair<Stop*, Stop*>, uint64_t, Hasher> distances_;
+
+        Bus* FindBus(std::string_view bus);
+        //расчёт статистики автобуса по его маршруту
+        void ComputeBusStat(Bus& bus);
+        //пересчёт статистики автобусов, проходящих через остановку
+        void ComputeBusStatsForStop(std::string_view stop);
+        void RemoveBusFromStops(Bus* bus);
     };
 }
\ No newline at end of file
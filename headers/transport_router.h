@@ -1,46 +1,75 @@
 #pragma once
 
 #include "graph.h"
+#include "path_search.h"
 #include "router.h"
 #include "transport_catalogue.h"
 
 #include <deque>
 #include <map>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace transport_router {
     class TransportRouter {
     public:
+        //Названия остановок и автобусов ссылаются на пул строк каталога
         struct Ids {
             ::graph::VertexId id;
             bool is_transfer;
-            std::string name;
+            std::string_view name;
         };
 
         struct EdgeInfo {
             ::graph::VertexId id_from;
             ::graph::VertexId id_to;
 
-            std::string bus;
+            std::string_view bus;
             int span_count;
             double time;
             bool is_bus_type;
-            std::string stop_name;
+            std::string_view stop_name;
+        };
+
+        //Пеший участок между точкой и остановкой
+        struct WalkInfo {
+            std::string_view stop_name;
+            double time;
         };
 
         struct RouteInfo {
-            std::deque<EdgeInfo*> edges;
+            std::deque<const EdgeInfo*> edges;
             double total_time;
+            std::optional<WalkInfo> walk_from;
+            std::optional<WalkInfo> walk_to;
         };
 
+        //Остановка и время пешком от неё (до неё) в минутах
+        using StopsWithWalkTime = std::vector<std::pair<std::string_view, double>>;
+
         TransportRouter(size_t vertex_count);
-        ::graph::DirectedWeightedGraph<double>& CreateGraph(::directory::TransportCatalogue& tr, const std::pair<int, double>& routing_settings);
-        ::graph::DirectedWeightedGraph<double>& GetGraph();
-        RouteInfo GetRoute(::graph::Router<double>& router, std::string_view from, std::string_view to);
+        ::graph::DirectedWeightedGraph<double>& CreateGraph(const ::directory::TransportCatalogue& tr, const std::pair<int, double>& routing_settings);
+        const ::graph::DirectedWeightedGraph<double>& GetGraph() const;
+        RouteInfo GetRoute(const ::graph::Router<double>& router, std::string_view from, std::string_view to) const;
+
+        //Один поиск от всех начальных остановок сразу до ближайшей по времени из конечных
+        RouteInfo GetRoute(const StopsWithWalkTime& from, const StopsWithWalkTime& to) const;
+
+        //Маршруты от одних начальных остановок до каждого набора конечных: один поиск на все наборы.
+        //Ответ для набора to[i] совпадает с GetRoute(from, to[i])
+        std::vector<RouteInfo> GetRoutes(const StopsWithWalkTime& from, const std::vector<StopsWithWalkTime>& to) const;
 
         ::graph::DirectedWeightedGraph<double>& Restore(std::vector <::graph::Edge<double>>& edges, ::graph::VertexId& curr_id,
             std::deque<Ids>& id_s, std::map<::graph::EdgeId, EdgeInfo>& edges_id);
 
-        void GetVariable(::graph::VertexId& curr_id, std::deque<Ids>& id_s, std::map<::graph::EdgeId, EdgeInfo>& edges_id);
+        void GetVariable(::graph::VertexId& curr_id, std::deque<Ids>& id_s, std::map<::graph::EdgeId, EdgeInfo>& edges_id) const;
+
+        //Замена рёбер автобуса после изменения базы, рёбра удалённого автобуса убираются из графа.
+        //Построенный по старому графу Router после этого использовать нельзя
+        void UpdateBusEdges(const ::directory::TransportCatalogue& tr, const std::pair<int, double>& routing_settings, std::string_view bus_name);
 
     private:
         ::graph::VertexId current_id = 0;
@@ -49,14 +78,20 @@ namespace transport_router {
 
         ::graph::DirectedWeightedGraph<double> dwg;
 
+        //Рёбра каждого автобуса, строится при первом изменении графа
+        std::optional<std::unordered_map<std::string_view, std::vector<::graph::EdgeId>>> bus_edges_;
+
         ::graph::VertexId GetNewVertexId(std::string_view stop, bool is_transfer);
-        Ids* GetStructForName(std::string_view stop, bool is_transfer);
+        const Ids* GetStructForName(std::string_view stop, bool is_transfer) const;
         void WriteNewEdge(::graph::EdgeId edge_id, EdgeInfo info);
-        EdgeInfo* GetVertexForEdge(::graph::EdgeId edge_id);
+        const EdgeInfo* GetVertexForEdge(::graph::EdgeId edge_id) const;
+
+        //Рёбра одного автобуса. При изменении графа ребро ожидания добавляется только новым остановкам
+        void AddBusEdges(const ::directory::TransportCatalogue& tr, const std::pair<int, double>& routing_settings, const ::directory::Bus* bus, bool is_update);
 
         template<typename Iterator>
-        void FillInfo(Iterator iter_to, Iterator iter_from, uint64_t dis, ::directory::TransportCatalogue& tr, const std::pair<int, double>& routing_settings, 
-                      int span_count, ::directory::Bus* bus, ::graph::VertexId id_from) {
+        void FillInfo(Iterator iter_to, Iterator iter_from, uint64_t dis, const ::directory::TransportCatalogue& tr, const std::pair<int, double>& routing_settings, 
+                      int span_count, const ::directory::Bus* bus, ::graph::VertexId id_from) {
 
             using namespace std::literals;
 
@@ -1,61 +1,284 @@
+#include "catalogue_snapshot.h"
 #include "domain.h"
 #include "graph.h"
 #include "json_reader.h"
+#include "profiler.h"
 #include "router.h"
 #include "serialization.h"
+#include "thread_pool.h"
 #include "transport_catalogue.h"
 
+#include <charconv>
+#include <fstream>
+#include <memory>
+#include <optional>
+
 using namespace std::literals;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base|process_requests|serve] [--compact] [--threads=N] [--worker-stats] [--stats[=FILE]] [--latency]\n"sv;
+}
+
+//База, загруженная из файла, со всеми восстановленными структурами
+struct LoadedBase {
+    std::string path;
+    ::serialization_space::SerializeVariable serialize_variable;
+    std::optional<::renderer::RequestHandler> rh;
+};
+
+std::unique_ptr<LoadedBase> LoadBase(const std::string& path, ::profiler::PhaseProfiler& profiler) {
+    auto base = std::make_unique<LoadedBase>();
+    base->path = path;
+    ::serialization_space::SerializeVariable& serialize_variable = base->serialize_variable;
+
+    ::directory::TransportCatalogue tr;
+    {
+        ::profiler::ScopedPhase phase(profiler, "deserialize"sv);
+        ::serialization_space::Serialization srlz(serialize_variable, path);
+        srlz.Deserialize(tr);
+    }
+
+    ::renderer::RequestHandler& rh = base->rh.emplace(::directory::MakeSnapshot(std::move(tr)), serialize_variable.renderer, serialize_variable.routing_settings);
+    {
+        ::profiler::ScopedPhase phase(profiler, "restore_router"sv);
+        rh.RestoreGraph(serialize_variable.edges, serialize_variable.vertex_count, serialize_variable.current_id, serialize_variable.id_s_, serialize_variable.edges_id_);
+    }
+    {
+        ::profiler::ScopedPhase phase(profiler, "restore_indices"sv);
+        rh.RestoreSpatialIndex(serialize_variable.grid);
+        rh.RestoreStopSearch(serialize_variable.name_index);
+        rh.SetIncidenceIndex();
+        rh.SetWalkVelocity(serialize_variable.walk_velocity);
+    }
+
+    return base;
+}
+
+void ApplyUpdates(::renderer::RequestHandler& rh, const std::vector<::directory::json_detail::QueryUpdate>& update_queries) {
+    try {
+        rh.ApplyUpdates(update_queries);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "base_requests are not applied: "sv << e.what() << std::endl;
+    }
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
+    if (argc < 2) {
         PrintUsage();
         return 1;
     }
 
     const std::string_view mode(argv[1]);
 
+    //Ответы без пробелов и переводов строк
+    ::json::Writer::Format format = ::json::Writer::Format::PRETTY;
+    //Число потоков для ответов на stat_requests
+    size_t threads = 1;
+    //Загрузка потоков пула в stderr по окончании работы
+    bool worker_stats = false;
+    //Время и память по этапам работы: в stderr или в файл stats_path
+    bool stats = false;
+    std::string stats_path;
+    //Гистограммы времени stat_requests по типам запросов
+    bool latency = false;
+    for (int i = 2; i < argc; ++i) {
+        const std::string_view option(argv[i]);
+        const std::string_view threads_option = "--threads="sv;
+        if (option == "--compact"sv) {
+            format = ::json::Writer::Format::COMPACT;
+        }
+        else if (option == "--worker-stats"sv) {
+            worker_stats = true;
+        }
+        else if (option == "--latency"sv) {
+            latency = true;
+        }
+        else if (option == "--stats"sv) {
+            stats = true;
+        }
+        else if (option.substr(0, "--stats="sv.size()) == "--stats="sv && option.size() > "--stats="sv.size()) {
+            stats = true;
+            stats_path = option.substr("--stats="sv.size());
+        }
+        else if (option.substr(0, threads_option.size()) == threads_option) {
+            const std::string_view value = option.substr(threads_option.size());
+            const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), threads);
+            if (ec != std::errc() || ptr != value.data() + value.size() || threads == 0) {
+                PrintUsage();
+                return 1;
+            }
+        }
+        else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    ::profiler::PhaseProfiler profiler;
+    ::profiler::LatencyStats latency_stats;
+    ::profiler::LatencyStats* const latency_ptr = latency ? &latency_stats : nullptr;
+    std::optional<::thread_pool::ThreadPool> pool;
+    if (threads > 1 || worker_stats) {
+        pool.emplace(threads);
+    }
+
     if (mode == "make_base"sv) {
         ::directory::TransportCatalogue tr;
         ::serialization_space::SerializeVariable serialize_variable;
         std::string path;
 
-        ::directory::json_detail::JsonReader j_reader;
-        j_reader.ReadMakeBase(std::cin, serialize_variable, path);
-
         ::renderer::RequestHandler rh(tr, serialize_variable.renderer, serialize_variable.routing_settings);
-        rh.FillTransportCatalogue(serialize_variable);
-        rh.SetRouterWithNewGraph();
-        rh.GetVariableForGraph(serialize_variable.edges, serialize_variable.vertex_count);
-        rh.GetVariableTransportRouter(serialize_variable.current_id, serialize_variable.id_s_, serialize_variable.edges_id_);
 
-        ::serialization_space::Serialization srlz(serialize_variable, path);
-        srlz.Serialize();
+        ::directory::json_detail::JsonReader j_reader;
+        bool is_read = false;
+        {
+            ::profiler::ScopedPhase phase(profiler, "read_base"sv);
+            is_read = j_reader.ReadMakeBase(std::cin, serialize_variable, path, rh);
+        }
+        if (!is_read) {
+            return 1;
+        }
+        {
+            ::profiler::ScopedPhase phase(profiler, "build_router"sv);
+            rh.SetRouterWithNewGraph();
+            rh.GetVariableForGraph(serialize_variable.edges, serialize_variable.vertex_count);
+            rh.GetVariableTransportRouter(serialize_variable.current_id, serialize_variable.id_s_, serialize_variable.edges_id_);
+        }
+        {
+            ::profiler::ScopedPhase phase(profiler, "build_indices"sv);
+            rh.SetSpatialIndex();
+            rh.GetVariableSpatialIndex(serialize_variable.grid);
+            rh.SetStopSearch();
+            rh.GetVariableStopSearch(serialize_variable.name_index);
+        }
+        {
+            ::profiler::ScopedPhase phase(profiler, "serialize"sv);
+            ::serialization_space::Serialization srlz(serialize_variable, path);
+            srlz.Serialize(tr);
+        }
     }
     else if (mode == "process_requests"sv) {
-        std::vector<::directory::json_detail::QueryStat> stat_queries;
-        ::directory::TransportCatalogue tr;
-        ::serialization_space::SerializeVariable serialize_variable;
+        std::vector<::directory::json_detail::QueryUpdate> update_queries;
         std::string path;
 
         ::directory::json_detail::JsonReader j_reader;
-        j_reader.ReadProcessRequests(std::cin, stat_queries, path);
-        ::serialization_space::Serialization srlz(serialize_variable, path);
-        srlz.Deserialize();
+        bool is_read = false;
+        {
+            ::profiler::ScopedPhase phase(profiler, "read_requests"sv);
+            is_read = j_reader.ReadProcessRequests(std::cin, update_queries, path);
+        }
+        if (!is_read) {
+            return 1;
+        }
 
-        ::renderer::RequestHandler rh(tr, serialize_variable.renderer, serialize_variable.routing_settings);
-        rh.FillTransportCatalogue(serialize_variable);
-        rh.RestoreGraph(serialize_variable.edges, serialize_variable.vertex_count, serialize_variable.current_id, serialize_variable.id_s_, serialize_variable.edges_id_);
-        j_reader.PrintStatRequests(rh, stat_queries, std::cout);
+        std::unique_ptr<LoadedBase> base;
+        try {
+            base = LoadBase(path, profiler);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "base is not loaded: "sv << e.what() << std::endl;
+            return 1;
+        }
+        {
+            ::profiler::ScopedPhase phase(profiler, "apply_updates"sv);
+            ApplyUpdates(*base->rh, update_queries);
+        }
+        {
+            ::profiler::ScopedPhase phase(profiler, "stat_requests"sv);
+            j_reader.PrintStatRequests(*base->rh, std::cout, format, pool ? &*pool : nullptr, latency_ptr);
+            std::cout.flush();
+        }
+    }
+    else if (mode == "serve"sv) {
+        //Каждая строка ввода - запрос в формате process_requests, ответ - одна строка.
+        //База загружается один раз и перечитывается, только если в запросе указан другой файл.
+        //Изменения из base_requests сохраняются для следующих запросов.
+        //Строка latency вместо запроса - вывод гистограмм времени запросов на текущий момент.
+        //На строку, которая не разобрана или для которой нет базы, выводится пустая строка,
+        //ошибка - в stderr, загруженная база со всеми изменениями остаётся прежней
+        std::unique_ptr<LoadedBase> base;
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            const size_t begin = line.find_first_not_of(" \t\r"sv);
+            if (begin == std::string::npos) {
+                continue;
+            }
+            if (std::string_view(line).substr(begin, line.find_last_not_of(" \t\r"sv) + 1 - begin) == "latency"sv) {
+                if (latency) {
+                    latency_stats.Print(std::cout);
+                }
+                else {
+                    std::cout << "{\"error_message\":\"latency recording is disabled, run with --latency\"}\n"sv;
+                }
+                std::cout.flush();
+                continue;
+            }
+
+            std::vector<::directory::json_detail::QueryUpdate> update_queries;
+            std::string path;
+
+            ::directory::json_detail::JsonReader j_reader;
+            bool is_read = false;
+            {
+                ::profiler::ScopedPhase phase(profiler, "read_requests"sv);
+                is_read = j_reader.ReadProcessRequests(std::move(line), update_queries, path);
+            }
+            if (!is_read) {
+                std::cout << std::endl;
+                continue;
+            }
+
+            //Без serialization_settings запрос идёт к уже загруженной базе
+            if (path.empty() && !base) {
+                std::cerr << "serialization_settings are not set and no base is loaded"sv << std::endl;
+                std::cout << std::endl;
+                continue;
+            }
+            if (!path.empty() && (!base || base->path != path)) {
+                try {
+                    base = LoadBase(path, profiler);
+                }
+                catch (const std::exception& e) {
+                    std::cerr << "base is not loaded: "sv << e.what() << std::endl;
+                    std::cout << std::endl;
+                    continue;
+                }
+            }
+            {
+                ::profiler::ScopedPhase phase(profiler, "apply_updates"sv);
+                ApplyUpdates(*base->rh, update_queries);
+            }
+            {
+                ::profiler::ScopedPhase phase(profiler, "stat_requests"sv);
+                j_reader.PrintStatRequests(*base->rh, std::cout, ::json::Writer::Format::COMPACT, pool ? &*pool : nullptr, latency_ptr);
+                std::cout << std::endl;
+            }
+        }
     }
     else {
         PrintUsage();
         return 1;
     }
+
+    if (latency) {
+        latency_stats.Print(std::cerr);
+    }
+
+    if (worker_stats && pool) {
+        ::thread_pool::PrintStats(*pool, std::cerr);
+    }
+
+    if (stats && stats_path.empty()) {
+        profiler.Print(mode, std::cerr);
+    }
+    else if (stats) {
+        std::ofstream stats_file(stats_path, std::ios::app);
+        profiler.Print(mode, stats_file);
+        if (!stats_file) {
+            std::cerr << "Can't write stats to "sv << stats_path << std::endl;
+        }
+    }
 }
 
 
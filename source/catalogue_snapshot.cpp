@@ -0,0 +1,10 @@
+#include "catalogue_snapshot.h"
+
+namespace directory {
+
+    using namespace std;
+
+    CatalogueSnapshot MakeSnapshot(TransportCatalogue&& catalogue) {
+        return make_shared<const TransportCatalogue>(move(catalogue));
+    }
+}
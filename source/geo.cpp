@@ -1,10 +1,21 @@
 #define _USE_MATH_DEFINES
 #include "geo.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace geo {
 
+    namespace {
+        const double DR = M_PI / 180.0;
+        const double EARTH_RADIUS = 6371000;
+    }
+
+    PreparedCoordinates PrepareCoordinates(Coordinates coordinates) {
+        using namespace std;
+        return { sin(coordinates.lat * DR), cos(coordinates.lat * DR), coordinates.lng * DR };
+    }
+
     double ComputeDistance(Coordinates from, Coordinates to) {
         using namespace std;
         const double dr = M_PI / 180.0;
@@ -12,4 +23,19 @@ namespace geo {
                     + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
             * 6371000;
     }
-}  // namespace geo
\ No newline at end of file
+
+    double ComputeDistance(const PreparedCoordinates& from, const PreparedCoordinates& to) {
+        using namespace std;
+        // Для совпадающих точек из-за погрешности аргумент может чуть превысить единицу
+        return acos(min(1.0, from.sin_lat * to.sin_lat + from.cos_lat * to.cos_lat * cos(from.lng_rad - to.lng_rad)))
+            * EARTH_RADIUS;
+    }
+
+    double ComputeRouteDistance(const std::vector<PreparedCoordinates>& points) {
+        double length = 0;
+        for (size_t i = 1; i < points.size(); ++i) {
+            length += ComputeDistance(points[i - 1], points[i]);
+        }
+        return length;
+    }
+}  // namespace geo
@@ -0,0 +1,226 @@
+#include "incidence_index.h"
+
+#include <algorithm>
+#include <bitset>
+#include <iterator>
+
+namespace incidence_index {
+
+    using namespace std;
+
+    namespace {
+        int CountBits(uint64_t word) {
+            return static_cast<int>(bitset<64>(word).count());
+        }
+
+        //Номер младшего установленного бита: единицы ниже него и есть ответ
+        int CountTrailingZeros(uint64_t word) {
+            return CountBits((word & (~word + 1)) - 1);
+        }
+    }
+
+    bool CompressedBitset::Container::IsBitmap() const {
+        return !bitmap.empty();
+    }
+
+    bool CompressedBitset::Container::Contains(uint16_t low) const {
+        if (IsBitmap()) {
+            return (bitmap[low >> 6] >> (low & 63)) & 1;
+        }
+        return binary_search(array.begin(), array.end(), low);
+    }
+
+    CompressedBitset::CompressedBitset(const vector<uint32_t>& sorted_values) {
+        for (uint32_t value : sorted_values) {
+            const uint16_t key = static_cast<uint16_t>(value >> 16);
+            if (containers_.empty() || containers_.back().key != key) {
+                if (!containers_.empty()) {
+                    Optimize(containers_.back());
+                }
+                containers_.push_back({ key, {}, {}, 0 });
+            }
+            Container& container = containers_.back();
+            container.array.push_back(static_cast<uint16_t>(value & 0xFFFF));
+            ++container.count;
+        }
+
+        if (!containers_.empty()) {
+            Optimize(containers_.back());
+        }
+    }
+
+    void CompressedBitset::Optimize(Container& container) {
+        if (container.IsBitmap() && container.count < ARRAY_LIMIT) {
+            vector<uint16_t> array;
+            array.reserve(container.count);
+            for (size_t word = 0; word < BITMAP_WORDS; ++word) {
+                for (uint64_t bits = container.bitmap[word]; bits != 0; bits &= bits - 1) {
+                    array.push_back(static_cast<uint16_t>(word * 64 + CountTrailingZeros(bits)));
+                }
+            }
+            container.array = move(array);
+            container.bitmap.clear();
+        }
+        else if (!container.IsBitmap() && container.count >= ARRAY_LIMIT) {
+            container.bitmap.assign(BITMAP_WORDS, 0);
+            for (uint16_t low : container.array) {
+                container.bitmap[low >> 6] |= uint64_t{ 1 } << (low & 63);
+            }
+            container.array.clear();
+            container.array.shrink_to_fit();
+        }
+    }
+
+    const CompressedBitset::Container* CompressedBitset::FindContainer(uint16_t key) const {
+        const auto iter = lower_bound(containers_.begin(), containers_.end(), key, [](const Container& container, uint16_t value) {
+            return container.key < value; });
+        return iter != containers_.end() && iter->key == key ? &*iter : nullptr;
+    }
+
+    bool CompressedBitset::Contains(uint32_t value) const {
+        const Container* container = FindContainer(static_cast<uint16_t>(value >> 16));
+        return container != nullptr && container->Contains(static_cast<uint16_t>(value & 0xFFFF));
+    }
+
+    size_t CompressedBitset::GetCount() const {
+        size_t result = 0;
+        for (const Container& container : containers_) {
+            result += container.count;
+        }
+        return result;
+    }
+
+    bool CompressedBitset::IsEmpty() const {
+        return containers_.empty();
+    }
+
+    vector<uint32_t> CompressedBitset::GetValues() const {
+        vector<uint32_t> result;
+        result.reserve(GetCount());
+        for (const Container& container : containers_) {
+            const uint32_t high = static_cast<uint32_t>(container.key) << 16;
+            if (container.IsBitmap()) {
+                for (size_t word = 0; word < BITMAP_WORDS; ++word) {
+                    for (uint64_t bits = container.bitmap[word]; bits != 0; bits &= bits - 1) {
+                        result.push_back(high | static_cast<uint32_t>(word * 64 + CountTrailingZeros(bits)));
+                    }
+                }
+            }
+            else {
+                for (uint16_t low : container.array) {
+                    result.push_back(high | low);
+                }
+            }
+        }
+        return result;
+    }
+
+    CompressedBitset::Container CompressedBitset::IntersectContainers(const Container& lhs, const Container& rhs) {
+        Container result{ lhs.key, {}, {}, 0 };
+
+        if (lhs.IsBitmap() && rhs.IsBitmap()) {
+            result.bitmap.resize(BITMAP_WORDS);
+            for (size_t word = 0; word < BITMAP_WORDS; ++word) {
+                result.bitmap[word] = lhs.bitmap[word] & rhs.bitmap[word];
+                result.count += CountBits(result.bitmap[word]);
+            }
+            Optimize(result);
+            return result;
+        }
+
+        if (lhs.IsBitmap() || rhs.IsBitmap()) {
+            //Массив проверяется по битовой карте
+            const Container& sparse = lhs.IsBitmap() ? rhs : lhs;
+            const Container& dense = lhs.IsBitmap() ? lhs : rhs;
+            for (uint16_t low : sparse.array) {
+                if (dense.Contains(low)) {
+                    result.array.push_back(low);
+                }
+            }
+        }
+        else {
+            set_intersection(lhs.array.begin(), lhs.array.end(), rhs.array.begin(), rhs.array.end(), back_inserter(result.array));
+        }
+
+        result.count = static_cast<uint32_t>(result.array.size());
+        return result;
+    }
+
+    CompressedBitset CompressedBitset::Intersect(const CompressedBitset& other) const {
+        CompressedBitset result;
+        auto lhs = containers_.begin();
+        auto rhs = other.containers_.begin();
+
+        while (lhs != containers_.end() && rhs != other.containers_.end()) {
+            if (lhs->key < rhs->key) {
+                ++lhs;
+            }
+            else if (rhs->key < lhs->key) {
+                ++rhs;
+            }
+            else {
+                Container container = IntersectContainers(*lhs, *rhs);
+                if (container.count > 0) {
+                    result.containers_.push_back(move(container));
+                }
+                ++lhs;
+                ++rhs;
+            }
+        }
+
+        return result;
+    }
+
+    IncidenceIndex::IncidenceIndex(const vector<vector<uint32_t>>& stop_bus_ids) {
+        vector<vector<uint32_t>> bus_stop_ids;
+        stop_to_buses_.reserve(stop_bus_ids.size());
+
+        for (size_t stop_id = 0; stop_id < stop_bus_ids.size(); ++stop_id) {
+            stop_to_buses_.emplace_back(stop_bus_ids[stop_id]);
+            for (uint32_t bus_id : stop_bus_ids[stop_id]) {
+                if (bus_id >= bus_stop_ids.size()) {
+                    bus_stop_ids.resize(bus_id + 1);
+                }
+                //Остановки перебираются по возрастанию, поэтому списки автобусов уже отсортированы
+                bus_stop_ids[bus_id].push_back(static_cast<uint32_t>(stop_id));
+            }
+        }
+
+        bus_to_stops_.reserve(bus_stop_ids.size());
+        for (const auto& stop_ids : bus_stop_ids) {
+            bus_to_stops_.emplace_back(stop_ids);
+        }
+    }
+
+    vector<uint32_t> IncidenceIndex::IntersectAll(const vector<CompressedBitset>& sets, const vector<size_t>& ids) {
+        if (ids.empty()) {
+            return {};
+        }
+
+        //Пересечение начинается с самого маленького множества
+        vector<const CompressedBitset*> ordered;
+        ordered.reserve(ids.size());
+        for (size_t id : ids) {
+            if (id >= sets.size()) {
+                return {};
+            }
+            ordered.push_back(&sets[id]);
+        }
+        sort(ordered.begin(), ordered.end(), [](const CompressedBitset* lhs, const CompressedBitset* rhs) {
+            return lhs->GetCount() < rhs->GetCount(); });
+
+        CompressedBitset result = *ordered.front();
+        for (auto iter = next(ordered.begin()); iter != ordered.end() && !result.IsEmpty(); ++iter) {
+            result = result.Intersect(**iter);
+        }
+        return result.GetValues();
+    }
+
+    vector<uint32_t> IncidenceIndex::GetCommonBuses(const vector<size_t>& stop_ids) const {
+        return IntersectAll(stop_to_buses_, stop_ids);
+    }
+
+    vector<uint32_t> IncidenceIndex::GetCommonStops(const vector<size_t>& bus_ids) const {
+        return IntersectAll(bus_to_stops_, bus_ids);
+    }
+}
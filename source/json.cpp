@@ -1,239 +1,87 @@
 #include "json.h"
+#include "json_parser.h"
+#include "json_scan.h"
+
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <system_error>
 
 using namespace std;
 
 namespace json {
 
-    namespace {
-
-        string GetString(std::istream& input) {
-            string result;
-            while (isalpha(input.peek())) {
-                result.push_back(static_cast<char>(input.get()));
-            }
-            return result;
+    Dict::Dict(Items items)
+        : items_(move(items)) {
+        const auto less = [](const value_type& lhs, const value_type& rhs) {
+            return lhs.first < rhs.first;
+        };
+        if (!is_sorted(items_.begin(), items_.end(), less)) {
+            stable_sort(items_.begin(), items_.end(), less);
         }
+        items_.erase(unique(items_.begin(), items_.end(), [](const value_type& lhs, const value_type& rhs) {
+            return lhs.first == rhs.first;
+        }), items_.end());
+    }
 
-        Node LoadNode(istream& input);
-
-        Node LoadArray(istream& input) {
-            Array result;
+    Dict::const_iterator Dict::begin() const {
+        return items_.begin();
+    }
 
-            for (char c; input >> c && c != ']';) {
-                if (c != ',') {
-                    input.putback(c);
-                }
-                result.push_back(LoadNode(input));
-            }
-            if (!input) {
-                throw ParsingError("LoadArray error"s);
-            }
-            return Node(move(result));
-        }
+    Dict::const_iterator Dict::end() const {
+        return items_.end();
+    }
 
-        Node LoadString(istream& input) {
-            auto it = std::istreambuf_iterator<char>(input);
-            auto end = std::istreambuf_iterator<char>();
-            string result;
-            while (true) {
-
-                if (it == end) {
-                    throw ParsingError("String parsing error");
-                }
-
-                const char ch = *it;
-
-                if (ch == '"') {
-                    ++it;
-                    break;
-                }
-                else if (ch == '\\') {
-                    ++it;
-                    if (it == end) {
-                        throw ParsingError("String parsing error");
-                    }
-                    const char escaped_char = *(it);
-                    switch (escaped_char) {
-                    case 'n':
-                        result.push_back('\n');
-                        break;
-                    case 't':
-                        result.push_back('\t');
-                        break;
-                    case 'r':
-                        result.push_back('\r');
-                        break;
-                    case '"':
-                        result.push_back('"');
-                        break;
-                    case '\\':
-                        result.push_back('\\');
-                        break;
-                    default:
-                        throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
-                    }
-                }
-                else if (ch == '\n' || ch == '\r') {
-                    throw ParsingError("Unexpected end of line"s);
-                }
-                else {
-                    result.push_back(ch);
-                }
-                ++it;
-            }
-            return Node(move(result));
-        }
+    size_t Dict::size() const {
+        return items_.size();
+    }
 
+    bool Dict::empty() const {
+        return items_.empty();
+    }
 
-        Node LoadBool(istream& input) {
-            string result = GetString(input);
+    Dict::const_iterator Dict::LowerBound(string_view key) const {
+        return lower_bound(items_.begin(), items_.end(), key, [](const value_type& item, string_view key) {
+            return item.first < key;
+        });
+    }
 
-            if (result == "true"sv) {
-                return Node(true);
-            }
-            else if (result == "false"sv) {
-                return Node(false);
-            }
-            else {
-                throw ParsingError("Failed to parse '"s + result + "' as bool"s);
-            }
-        }
+    Dict::const_iterator Dict::find(string_view key) const {
+        const auto iter = LowerBound(key);
+        return iter != items_.end() && iter->first == key ? iter : items_.end();
+    }
 
-        Node LoadNull(istream& input) {
-            string result = GetString(input);;
+    size_t Dict::count(string_view key) const {
+        return find(key) != end() ? 1 : 0;
+    }
 
-            if (result == "null"s) {
-                return Node(nullptr);
-            }
-            else {
-                throw ParsingError("Failed to parse '"s + result + "' as null"s);
-            }
+    const Node& Dict::at(string_view key) const {
+        const auto iter = find(key);
+        if (iter == end()) {
+            throw out_of_range("Key '"s + string(key) + "' is not found"s);
         }
+        return iter->second;
+    }
 
-        Node LoadDict(std::istream& input) {
-            Dict result;
-
-            for (char c; input >> c && c != '}';) {
-                if (c == '"') {
-                    std::string key = LoadString(input).AsString();
-                    if (input >> c && c == ':') {
-                        if (result.find(key) != result.end()) {
-                            throw ParsingError("Duplicate key '"s + key + "' have been found");
-                        }
-                        result.emplace(move(key), LoadNode(input));
-                    }
-                    else {
-                        throw ParsingError(": is expected but '"s + c + "' has been found"s);
-                    }
-                }
-                else if (c != ',') {
-                    throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
-                }
-            }
-            if (!input) {
-                throw ParsingError("Dictionary parsing error"s);
-            }
-
-            return Node(move(result));
+    pair<Dict::iterator, bool> Dict::insert(value_type item) {
+        const auto iter = LowerBound(item.first);
+        if (iter != items_.end() && iter->first == item.first) {
+            return { iter, false };
         }
+        return { items_.insert(iter, move(item)), true };
+    }
 
-        Node LoadNumber(std::istream& input) {
-            using namespace std::literals;
-
-            std::string parsed_num;
-
-            // Считывает в parsed_num очередной символ из input
-            auto read_char = [&parsed_num, &input] {
-                parsed_num += static_cast<char>(input.get());
-                if (!input) {
-                    throw ParsingError("Failed to read number from stream"s);
-                }
-            };
-
-            // Считывает одну или более цифр в parsed_num из input
-            auto read_digits = [&input, read_char] {
-                if (!std::isdigit(input.peek())) {
-                    throw ParsingError("A digit is expected"s);
-                }
-                while (std::isdigit(input.peek())) {
-                    read_char();
-                }
-            };
-
-            if (input.peek() == '-') {
-                read_char();
-            }
-            // Парсим целую часть числа
-            if (input.peek() == '0') {
-                read_char();
-                // После 0 в JSON не могут идти другие цифры
-            }
-            else {
-                read_digits();
-            }
-
-            bool is_int = true;
-            // Парсим дробную часть числа
-            if (input.peek() == '.') {
-                read_char();
-                read_digits();
-                is_int = false;
-            }
-
-            // Парсим экспоненциальную часть числа
-            if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-                read_char();
-                if (ch = input.peek(); ch == '+' || ch == '-') {
-                    read_char();
-                }
-                read_digits();
-                is_int = false;
-            }
-
-            try {
-                if (is_int) {
-                    // Сначала пробуем преобразовать строку в int
-                    try {
-                        return Node{ std::stoi(parsed_num) };
-                    }
-                    catch (...) {
-                        // В случае неудачи, например, при переполнении,
-                        // код ниже попробует преобразовать строку в double
-                    }
-                }
-                return Node{ std::stod(parsed_num) };
-            }
-            catch (...) {
-                throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
-            }
-        }
+    pair<Dict::iterator, bool> Dict::emplace(string key, Node value) {
+        return insert({ move(key), move(value) });
+    }
 
-        Node LoadNode(istream& input) {
-            char c;
-            input >> c;
-
-            switch (c) {
-            case '[':
-                return LoadArray(input);
-            case '{':
-                return LoadDict(input);
-            case '"':
-                return LoadString(input);
-            case 't':
-                [[fallthrough]];
-            case 'f':
-                input.putback(c);
-                return LoadBool(input);
-            case 'n':
-                input.putback(c);
-                return LoadNull(input);
-            default:
-                input.putback(c);
-                return LoadNumber(input);
-            }
-        }
+    bool Dict::operator==(const Dict& rhs) const {
+        return items_ == rhs.items_;
+    }
 
-    }  // namespace*******************************************************************************************************************
+    bool Dict::operator!=(const Dict& rhs) const {
+        return !(*this == rhs);
+    }
 
     bool Node::IsNull() const {
         return holds_alternative<nullptr_t>(*this);
@@ -322,7 +170,7 @@ namespace json {
         return *get_if<string>(this);
     }
 
-    Node::variant Node::GetValue() const {
+    const Node::Value& Node::GetValue() const {
         return *this;
     }
 
@@ -330,43 +178,77 @@ namespace json {
         : root_(move(root)) {
     }
 
+    Document::Document(unique_ptr<pmr::monotonic_buffer_resource> arena, Node root)
+        : arena_(move(arena))
+        , root_(move(root)) {
+    }
+
     const Node& Document::GetRoot() const {
         return root_;
     }
 
     Document Load(istream& input) {
-        return Document{ LoadNode(input) };
+        const std::string text = ReadAll(input);
+        return Load(std::string_view(text));
+    }
+
+    Document Load(std::string_view text) {
+        Parser parser(text);
+        auto arena = make_unique<pmr::monotonic_buffer_resource>();
+        Node root = LoadTree(parser, parser.Next(), arena.get());
+        return Document(move(arena), move(root));
+    }
+
+    std::string ReadAll(std::istream& input) {
+        std::string result;
+        char buffer[1 << 16];
+        while (input.read(buffer, sizeof(buffer)) || input.gcount() > 0) {
+            result.append(buffer, static_cast<size_t>(input.gcount()));
+        }
+        return result;
     }
 
     void PrintString(const std::string& value, std::ostream& out) {
         out.put('"');
-        for (const char c : value) {
-            switch (c) {
-            case '\r':
-                out << "\\r"sv;
-                break;
-            case '\n':
-                out << "\\n"sv;
-                break;
-            case '"':
-                [[fallthrough]];
-            case '\\':
-                out.put('\\');
-                [[fallthrough]];
-            default:
-                out.put(c);
-                break;
-            }
-        }
+        PrintEscaped(value, out);
         out.put('"');
     }
 
+    char* FormatNumber(int value, char* begin, char* end) {
+        return std::to_chars(begin, end, value).ptr;
+    }
+
+    char* FormatNumber(double value, const std::ios_base& format, char* begin, char* end) {
+        //Особые форматы потока выводятся им самим
+        if ((format.flags() & (std::ios_base::floatfield | std::ios_base::showpoint | std::ios_base::showpos | std::ios_base::uppercase)) != 0) {
+            return nullptr;
+        }
+
+        const auto result = std::to_chars(begin, end, value, std::chars_format::general, static_cast<int>(format.precision()));
+        return result.ec == std::errc{} ? result.ptr : nullptr;
+    }
+
+    void PrintNumber(int value, std::ostream& out) {
+        char buffer[16];
+        out.write(buffer, FormatNumber(value, buffer, buffer + sizeof(buffer)) - buffer);
+    }
+
+    void PrintNumber(double value, std::ostream& out) {
+        char buffer[64];
+        if (const char* buffer_end = FormatNumber(value, out, buffer, buffer + sizeof(buffer))) {
+            out.write(buffer, buffer_end - buffer);
+        }
+        else {
+            out << value;
+        }
+    }
+
     void PrintValue(const double value, const RenderContext& ctx) {
-        ctx.out << value;
+        PrintNumber(value, ctx.out);
     }
 
     void PrintValue(const int value, const RenderContext& ctx) {
-        ctx.out << value;
+        PrintNumber(value, ctx.out);
     }
 
     void PrintValue(const std::string& value, const RenderContext& ctx) {
@@ -69,11 +69,11 @@ namespace json {
 			root_ = GetNode(std::move(value));
 		}
 		else if (!nodes_stack_.empty() && nodes_stack_.back()->IsDict() && current_method_ == MethodTypes::KEY) {
-			std::map<std::string, Node>& m = const_cast<Dict&>(nodes_stack_.back()->AsDict());
+			Dict& m = const_cast<Dict&>(nodes_stack_.back()->AsDict());
 			m.insert({ key_.back(), GetNode(std::move(value)) });
 		}
 		else if (!nodes_stack_.empty() && nodes_stack_.back()->IsArray()) {
-			std::vector<Node>& m = const_cast<Array&>(nodes_stack_.back()->AsArray());
+			Array& m = const_cast<Array&>(nodes_stack_.back()->AsArray());
 			m.emplace_back(std::move(GetNode(std::move(value))));
 		}
 		else {
@@ -117,17 +117,17 @@ namespace json {
 			}
 
 			else if (nodes_stack_.at(nodes_stack_.size() - 2)->IsArray()) {
-				std::vector<Node>& m = const_cast<Array&>(nodes_stack_.at(nodes_stack_.size() - 2)->AsArray());
+				Array& m = const_cast<Array&>(nodes_stack_.at(nodes_stack_.size() - 2)->AsArray());
 				m.emplace_back(*nodes_stack_.back());
 			}
 
 			else if (nodes_stack_.at(nodes_stack_.size() - 2)->IsDict()) {
-				std::map<std::string, Node>& m = const_cast<Dict&>(nodes_stack_.at(nodes_stack_.size() - 2)->AsDict());
+				Dict& m = const_cast<Dict&>(nodes_stack_.at(nodes_stack_.size() - 2)->AsDict());
 				m.insert({ key_.back(), *nodes_stack_.back() });
 			}
 
 			{
-				std::map<std::string, Node>& m = const_cast<Dict&>(nodes_stack_.back()->AsDict());
+				Dict& m = const_cast<Dict&>(nodes_stack_.back()->AsDict());
 				if (!m.empty()) {
 					key_.pop_back();
 				}
@@ -155,7 +155,7 @@ namespace json {
 			}
 
 			else if (nodes_stack_.at(nodes_stack_.size() - 2)->IsArray()) {
-				std::vector<Node>& m = const_cast<Array&>(nodes_stack_.at(nodes_stack_.size() - 2)->AsArray());
+				Array& m = const_cast<Array&>(nodes_stack_.at(nodes_stack_.size() - 2)->AsArray());
 				m.emplace_back(*nodes_stack_.back());
 				nodes_stack_.pop_back();
 				current_method_ = MethodTypes::END_ARRAY;
@@ -163,7 +163,7 @@ namespace json {
 			}
 
 			else if (nodes_stack_.at(nodes_stack_.size() - 2)->IsDict()) {
-				std::map<std::string, Node>& m = const_cast<Dict&>(nodes_stack_.at(nodes_stack_.size() - 2)->AsDict());
+				Dict& m = const_cast<Dict&>(nodes_stack_.at(nodes_stack_.size() - 2)->AsDict());
 				m.insert({ key_.back(), *nodes_stack_.back() });
 				nodes_stack_.pop_back();
 				current_method_ = MethodTypes::END_ARRAY;
@@ -0,0 +1,507 @@
+#include "json_parser.h"
+#include "json_scan.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <stdexcept>
+#include <system_error>
+
+using namespace std;
+
+namespace json {
+
+    namespace {
+        bool IsSpace(char c) {
+            return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+        }
+
+        bool IsDigit(char c) {
+            return c >= '0' && c <= '9';
+        }
+
+        int GetHexDigit(char c) {
+            if (c >= '0' && c <= '9') {
+                return c - '0';
+            }
+            if (c >= 'a' && c <= 'f') {
+                return c - 'a' + 10;
+            }
+            if (c >= 'A' && c <= 'F') {
+                return c - 'A' + 10;
+            }
+            throw ParsingError("Invalid hex digit in \\u escape sequence"s);
+        }
+
+        void AppendUtf8(string& out, char32_t code_point) {
+            if (code_point < 0x80) {
+                out.push_back(static_cast<char>(code_point));
+            }
+            else if (code_point < 0x800) {
+                out.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+                out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+            }
+            else if (code_point < 0x10000) {
+                out.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+            }
+            else {
+                out.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+                out.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+            }
+        }
+    }
+
+    namespace {
+
+        Node LoadArray(Parser& parser, pmr::memory_resource* resource) {
+            Array result(resource);
+
+            for (Parser::Event event = parser.Next(); event != Parser::Event::END_ARRAY; event = parser.Next()) {
+                result.push_back(LoadNode(parser, event, resource));
+            }
+
+            return Node(move(result));
+        }
+
+        Node LoadDict(Parser& parser, pmr::memory_resource* resource) {
+            Dict::Items items(resource);
+
+            for (Parser::Event event = parser.Next(); event != Parser::Event::END_DICT; event = parser.Next()) {
+                std::string key(parser.GetString());
+                items.emplace_back(move(key), LoadNode(parser, parser.Next(), resource));
+            }
+
+            //Ключи сортируются один раз, повторы оказываются рядом
+            sort(items.begin(), items.end(), [](const Dict::value_type& lhs, const Dict::value_type& rhs) {
+                return lhs.first < rhs.first;
+            });
+            const auto duplicate = adjacent_find(items.begin(), items.end(), [](const Dict::value_type& lhs, const Dict::value_type& rhs) {
+                return lhs.first == rhs.first;
+            });
+            if (duplicate != items.end()) {
+                throw ParsingError("Duplicate key '"s + duplicate->first + "' have been found");
+            }
+
+            return Node(Dict(move(items)));
+        }
+
+
+        //Построение дерева с памятью из resource. Элементы открытых массивов и словарей копятся в общих стеках
+        //и переносятся в контейнер узла один раз, точно по размеру: в области документа память не освобождается,
+        //и рост контейнера по одному элементу оставлял бы в ней старые копии
+        class TreeLoader {
+        public:
+            TreeLoader(Parser& parser, pmr::memory_resource* resource)
+                : parser_(parser)
+                , resource_(resource) {
+            }
+
+            Node Load(Parser::Event event) {
+                switch (event) {
+                case Parser::Event::START_ARRAY:
+                    return LoadArray();
+                case Parser::Event::START_DICT:
+                    return LoadDict();
+                default:
+                    return LoadNode(parser_, event, resource_);
+                }
+            }
+
+        private:
+            Parser& parser_;
+            pmr::memory_resource* resource_;
+            vector<Node> array_stack_;
+            vector<Dict::value_type> dict_stack_;
+
+            Node LoadArray() {
+                const size_t begin = array_stack_.size();
+                for (Parser::Event event = parser_.Next(); event != Parser::Event::END_ARRAY; event = parser_.Next()) {
+                    array_stack_.push_back(Load(event));
+                }
+
+                Array result(make_move_iterator(array_stack_.begin() + begin), make_move_iterator(array_stack_.end()), resource_);
+                array_stack_.erase(array_stack_.begin() + begin, array_stack_.end());
+                return Node(move(result));
+            }
+
+            Node LoadDict() {
+                const size_t begin = dict_stack_.size();
+                for (Parser::Event event = parser_.Next(); event != Parser::Event::END_DICT; event = parser_.Next()) {
+                    std::string key(parser_.GetString());
+                    Node value = Load(parser_.Next());
+                    dict_stack_.emplace_back(move(key), move(value));
+                }
+
+                const auto items_begin = dict_stack_.begin() + begin;
+                //Ключи сортируются один раз, повторы оказываются рядом
+                sort(items_begin, dict_stack_.end(), [](const Dict::value_type& lhs, const Dict::value_type& rhs) {
+                    return lhs.first < rhs.first;
+                });
+                const auto duplicate = adjacent_find(items_begin, dict_stack_.end(), [](const Dict::value_type& lhs, const Dict::value_type& rhs) {
+                    return lhs.first == rhs.first;
+                });
+                if (duplicate != dict_stack_.end()) {
+                    throw ParsingError("Duplicate key '"s + duplicate->first + "' have been found");
+                }
+
+                Dict::Items items(make_move_iterator(items_begin), make_move_iterator(dict_stack_.end()), resource_);
+                dict_stack_.erase(items_begin, dict_stack_.end());
+                return Node(Dict(move(items)));
+            }
+        };
+
+    }
+
+    Parser::Parser(string_view text)
+        : pos_(text.data())
+        , end_(text.data() + text.size())
+        , begin_(text.data()) {
+    }
+
+    Parser::Parser(string& text)
+        : pos_(text.data())
+        , end_(text.data() + text.size())
+        , writable_begin_(text.data())
+        , begin_(text.data()) {
+    }
+
+    void Parser::SkipSpaces() {
+        while (pos_ != end_ && IsSpace(*pos_)) {
+            ++pos_;
+        }
+    }
+
+    char Parser::Peek() const {
+        return pos_ == end_ ? '\0' : *pos_;
+    }
+
+    Parser::Event Parser::Next() {
+        SkipSpaces();
+
+        if (state_ == State::VALUE) {
+            return ReadValue();
+        }
+
+        //Корневое значение прочитано, остаток входа не разбирается
+        if (stack_.empty()) {
+            return Event::END;
+        }
+
+        const char open = stack_.back();
+        const char close = open == '{' ? '}' : ']';
+
+        if (Peek() == close) {
+            return CloseContainer(close);
+        }
+
+        if (state_ == State::NEXT) {
+            if (Peek() != ',') {
+                throw ParsingError("',' or '"s + close + "' is expected"s);
+            }
+            ++pos_;
+            SkipSpaces();
+        }
+
+        return open == '{' ? ReadKey() : ReadValue();
+    }
+
+    Parser::Event Parser::CloseContainer(char close) {
+        ++pos_;
+        stack_.pop_back();
+        state_ = State::NEXT;
+        return close == '}' ? Event::END_DICT : Event::END_ARRAY;
+    }
+
+    Parser::Event Parser::ReadKey() {
+        if (Peek() != '"') {
+            throw ParsingError("Key is expected"s);
+        }
+        ++pos_;
+        ReadString();
+
+        SkipSpaces();
+        if (Peek() != ':') {
+            throw ParsingError("':' is expected after key"s);
+        }
+        ++pos_;
+
+        state_ = State::VALUE;
+        return Event::KEY;
+    }
+
+    Parser::Event Parser::ReadValue() {
+        state_ = State::NEXT;
+
+        switch (Peek()) {
+        case '{':
+            ++pos_;
+            stack_.push_back('{');
+            state_ = State::FIRST;
+            return Event::START_DICT;
+        case '[':
+            ++pos_;
+            stack_.push_back('[');
+            state_ = State::FIRST;
+            return Event::START_ARRAY;
+        case '"':
+            ++pos_;
+            ReadString();
+            return Event::STRING;
+        case 't':
+            ReadLiteral("true"sv);
+            bool_value_ = true;
+            return Event::BOOL;
+        case 'f':
+            ReadLiteral("false"sv);
+            bool_value_ = false;
+            return Event::BOOL;
+        case 'n':
+            ReadLiteral("null"sv);
+            return Event::NULL_VALUE;
+        case '\0':
+            if (pos_ == end_) {
+                throw ParsingError("Unexpected end of input"s);
+            }
+            [[fallthrough]];
+        default:
+            return ReadNumber();
+        }
+    }
+
+    void Parser::ReadLiteral(string_view literal) {
+        const string_view rest(pos_, end_ - pos_);
+        if (rest.substr(0, literal.size()) != literal) {
+            throw ParsingError("Failed to parse literal, '"s + string(literal) + "' is expected"s);
+        }
+        pos_ += literal.size();
+    }
+
+    void Parser::ReadString() {
+        const char* begin = pos_;
+
+        //Быстрый путь: строка без escape-последовательностей ссылается на буфер
+        pos_ = FindSpecialChar(pos_, end_);
+        if (pos_ != end_ && (*pos_ == '\n' || *pos_ == '\r')) {
+            throw ParsingError("Unexpected end of line"s);
+        }
+
+        if (pos_ == end_) {
+            throw ParsingError("String parsing error"s);
+        }
+
+        if (*pos_ == '"') {
+            string_ = string_view(begin, pos_ - begin);
+            ++pos_;
+            return;
+        }
+
+        unescaped_.assign(begin, pos_);
+        while (true) {
+            //Участок до следующего особого символа копируется целиком
+            const char* run_end = FindSpecialChar(pos_, end_);
+            unescaped_.append(pos_, run_end);
+            pos_ = run_end;
+            if (pos_ == end_) {
+                throw ParsingError("String parsing error"s);
+            }
+
+            const char ch = *pos_++;
+            if (ch == '"') {
+                break;
+            }
+            if (ch == '\n' || ch == '\r') {
+                throw ParsingError("Unexpected end of line"s);
+            }
+
+            if (pos_ == end_) {
+                throw ParsingError("String parsing error"s);
+            }
+
+            const char escaped_char = *pos_++;
+            switch (escaped_char) {
+            case 'n':
+                unescaped_.push_back('\n');
+                break;
+            case 't':
+                unescaped_.push_back('\t');
+                break;
+            case 'r':
+                unescaped_.push_back('\r');
+                break;
+            case 'b':
+                unescaped_.push_back('\b');
+                break;
+            case 'f':
+                unescaped_.push_back('\f');
+                break;
+            case '"':
+            case '\\':
+            case '/':
+                unescaped_.push_back(escaped_char);
+                break;
+            case 'u': {
+                auto read_code_unit = [this] {
+                    if (end_ - pos_ < 4) {
+                        throw ParsingError("String parsing error"s);
+                    }
+                    char32_t code_unit = 0;
+                    for (int i = 0; i < 4; ++i) {
+                        code_unit = (code_unit << 4) | GetHexDigit(*pos_++);
+                    }
+                    return code_unit;
+                };
+
+                char32_t code_point = read_code_unit();
+                //Символ вне базовой плоскости записывается суррогатной парой
+                if (code_point >= 0xD800 && code_point <= 0xDBFF && end_ - pos_ >= 2 && pos_[0] == '\\' && pos_[1] == 'u') {
+                    pos_ += 2;
+                    const char32_t low = read_code_unit();
+                    code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                }
+                AppendUtf8(unescaped_, code_point);
+                break;
+            }
+            default:
+                throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+            }
+        }
+
+        if (writable_begin_ != nullptr) {
+            //Декодированная строка не длиннее исходной, поэтому помещается на её место
+            char* dest = writable_begin_ + (begin - begin_);
+            unescaped_.copy(dest, unescaped_.size());
+            string_ = string_view(dest, unescaped_.size());
+        }
+        else {
+            string_ = unescaped_;
+        }
+    }
+
+    Parser::Event Parser::ReadNumber() {
+        const char* begin = pos_;
+
+        auto read_digits = [this] {
+            if (pos_ == end_ || !IsDigit(*pos_)) {
+                throw ParsingError("A digit is expected"s);
+            }
+            while (pos_ != end_ && IsDigit(*pos_)) {
+                ++pos_;
+            }
+        };
+
+        if (Peek() == '-') {
+            ++pos_;
+        }
+        // После 0 в JSON не могут идти другие цифры
+        if (Peek() == '0') {
+            ++pos_;
+        }
+        else {
+            read_digits();
+        }
+
+        bool is_int = true;
+        if (Peek() == '.') {
+            ++pos_;
+            read_digits();
+            is_int = false;
+        }
+
+        if (const char ch = Peek(); ch == 'e' || ch == 'E') {
+            ++pos_;
+            if (const char sign = Peek(); sign == '+' || sign == '-') {
+                ++pos_;
+            }
+            read_digits();
+            is_int = false;
+        }
+
+        if (is_int) {
+            // При переполнении int число читается как double
+            if (const auto result = from_chars(begin, pos_, int_value_); result.ec == errc{}) {
+                double_value_ = int_value_;
+                return Event::INT;
+            }
+        }
+
+        if (const auto result = from_chars(begin, pos_, double_value_); result.ec == errc{}) {
+            return Event::DOUBLE;
+        }
+
+        //За пределами double: strtod даёт бесконечность или 0, как и раньше.
+        //Буфер может не заканчиваться нулём, поэтому число копируется
+        const string parsed_num(begin, pos_);
+        double_value_ = strtod(parsed_num.c_str(), nullptr);
+        return Event::DOUBLE;
+    }
+
+    string_view Parser::GetString() const {
+        return string_;
+    }
+
+    int Parser::GetInt() const {
+        return int_value_;
+    }
+
+    double Parser::GetDouble() const {
+        return double_value_;
+    }
+
+    bool Parser::GetBool() const {
+        return bool_value_;
+    }
+
+    void Parser::Skip(Event event) {
+        if (event != Event::START_DICT && event != Event::START_ARRAY) {
+            return;
+        }
+
+        const size_t depth = stack_.size();
+        while (stack_.size() >= depth) {
+            Next();
+        }
+    }
+
+    string_view Parser::SkipRaw(Event event) {
+        if (event != Event::START_DICT && event != Event::START_ARRAY) {
+            throw ParsingError("Container is expected"s);
+        }
+        if (writable_begin_ != nullptr) {
+            throw logic_error("Raw text is not available while parsing in place"s);
+        }
+
+        const char* begin = pos_ - 1;
+        Skip(event);
+        return string_view(begin, pos_ - begin);
+    }
+
+    Node LoadNode(Parser& parser, Parser::Event event, pmr::memory_resource* resource) {
+        switch (event) {
+        case Parser::Event::START_ARRAY:
+            return LoadArray(parser, resource);
+        case Parser::Event::START_DICT:
+            return LoadDict(parser, resource);
+        case Parser::Event::STRING:
+            return Node(std::string(parser.GetString()));
+        case Parser::Event::INT:
+            return Node(parser.GetInt());
+        case Parser::Event::DOUBLE:
+            return Node(parser.GetDouble());
+        case Parser::Event::BOOL:
+            return Node(parser.GetBool());
+        case Parser::Event::NULL_VALUE:
+            return Node(nullptr);
+        default:
+            throw ParsingError("Unexpected token"s);
+        }
+    }
+
+    Node LoadTree(Parser& parser, Parser::Event event, pmr::memory_resource* resource) {
+        return TreeLoader(parser, resource).Load(event);
+    }
+
+}  // namespace json
@@ -1,41 +1,278 @@
 #include "map_renderer.h"
 #include "json_reader.h"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
 
 namespace directory {
     namespace json_detail {
         using namespace std;
 
-        void JsonReader::ReadBaseRequests(const ::json::Node& request, vector<QueryBus>& bus_queries, vector<QueryStop>& stop_queries) {
+        namespace {
+            using Clock = chrono::steady_clock;
+
+            //Число запросов на поток в одной части stat_requests. В большой части больше запросов Route
+            //с общим началом, которые выполняются одним поиском, но и больше ответов ждут вывода в памяти
+            const size_t STAT_CHUNK_PER_THREAD = 4096;
+
+            //Размер первой части stat_requests. Следующие части растут вдвое до полного размера,
+            //чтобы первые ответы выводились почти сразу, как при обработке запросов по одному
+            const size_t FIRST_STAT_CHUNK = 16;
+
+            //Размер кэша ответов, после которого он очищается
+            const size_t DEDUP_CACHE_SIZE = 16 << 20;
+
+            //Если среди первых DEDUP_PROBE_SIZE запросов пакета повторов меньше 1/DEDUP_MIN_HIT_RATE,
+            //поиск одинаковых запросов отключается до конца пакета: на различных запросах он только тратит время
+            const size_t DEDUP_PROBE_SIZE = 1024;
+            const size_t DEDUP_MIN_HIT_RATE = 64;
+
+            //Тип замера времени для обобщённой лямбды
+            template <typename Timer>
+            struct TimerType {
+                using Type = Timer;
+            };
+
+            //Ответ на запрос берётся из кэша
+            const size_t CACHED = numeric_limits<size_t>::max();
+
+            //Ответ, в котором номер запроса text[id_begin, id_end) заменяется на номер очередного такого же запроса
+            struct AnswerTemplate {
+                string text;
+                size_t id_begin = string::npos;
+                size_t id_end = string::npos;
+            };
+
+            template <typename T>
+            void AppendBytes(string& key, const T& value) {
+                key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+            }
+
+            void AppendString(string& key, string_view value) {
+                AppendBytes(key, value.size());
+                key += value;
+            }
+
+            void AppendPoint(string& key, const optional<::geo::Coordinates>& point) {
+                AppendBytes(key, point.has_value());
+                if (point) {
+                    AppendBytes(key, point->lat);
+                    AppendBytes(key, point->lng);
+                }
+            }
+
+            //Все поля запроса, кроме id: у запросов с одинаковым ключом одинаковые ответы
+            string MakeRequestKey(const QueryStat& query) {
+                string key;
+                AppendString(key, query.type);
+                AppendString(key, query.name);
+                AppendString(key, query.from);
+                AppendString(key, query.to);
+                AppendPoint(key, query.from_point);
+                AppendPoint(key, query.to_point);
+                AppendPoint(key, query.coordinates);
+                AppendBytes(key, query.count);
+                AppendBytes(key, query.radius);
+                AppendString(key, query.prefix);
+                AppendBytes(key, query.names.size());
+                for (const string& name : query.names) {
+                    AppendString(key, name);
+                }
+                return key;
+            }
+
+            //Начало маршрута: запросы Route с одинаковым ключом обслуживаются одним поиском
+            string MakeOriginKey(const QueryStat& query) {
+                string key;
+                AppendString(key, query.from);
+                AppendPoint(key, query.from_point);
+                return key;
+            }
+
+            AnswerTemplate MakeAnswerTemplate(string answer) {
+                AnswerTemplate result;
+                //Внутри строк JSON кавычка всегда экранирована, поэтому найденный ключ - ключ словаря ответа
+                const string_view key = "\"request_id\":"sv;
+                const size_t key_pos = answer.find(key);
+                if (key_pos != string::npos) {
+                    result.id_begin = answer.find_first_not_of(' ', key_pos + key.size());
+                    result.id_end = answer.find_first_not_of("-0123456789"sv, result.id_begin);
+                }
+                result.text = move(answer);
+                return result;
+            }
+
+            string_view FillAnswerTemplate(const AnswerTemplate& answer_template, int id, string& out) {
+                if (answer_template.id_begin == string::npos) {
+                    return answer_template.text;
+                }
+
+                char number[16];
+                const string_view text = answer_template.text;
+                out.assign(text.substr(0, answer_template.id_begin));
+                out.append(number, ::json::FormatNumber(id, number, number + sizeof(number)) - number);
+                out += text.substr(answer_template.id_end);
+                return out;
+            }
+
+            //Поля одного запроса к базе. Строки указывают в разбираемый текст
+            struct BaseRequest {
+                string_view type;
+                string_view name;
+                ::geo::Coordinates coordinates;
+                vector<pair<string_view, uint64_t>> road_distances;
+                vector<string_view> stops;
+                bool is_roundtrip = false;
+            };
+
+            //Проверка типа значения перед чтением из парсера, как в Node::As*: ошибка называет ключ
+            void CheckBaseValue(bool is_valid, string_view key, string_view type) {
+                if (!is_valid) {
+                    throw ::json::ParsingError("Base request value '"s + string(key) + "' is not "s + string(type));
+                }
+            }
+
+            BaseRequest ReadBaseRequest(::json::Parser& parser) {
+                using Event = ::json::Parser::Event;
+                BaseRequest result;
+
+                for (Event event = parser.Next(); event != Event::END_DICT; event = parser.Next()) {
+                    const string_view key = parser.GetString();
+                    event = parser.Next();
+
+                    if (key == "type"sv) {
+                        CheckBaseValue(event == Event::STRING, key, "a string"sv);
+                        result.type = parser.GetString();
+                    }
+                    else if (key == "name"sv) {
+                        CheckBaseValue(event == Event::STRING, key, "a string"sv);
+                        result.name = parser.GetString();
+                    }
+                    else if (key == "latitude"sv) {
+                        CheckBaseValue(event == Event::INT || event == Event::DOUBLE, key, "a number"sv);
+                        result.coordinates.lat = parser.GetDouble();
+                    }
+                    else if (key == "longitude"sv) {
+                        CheckBaseValue(event == Event::INT || event == Event::DOUBLE, key, "a number"sv);
+                        result.coordinates.lng = parser.GetDouble();
+                    }
+                    else if (key == "is_roundtrip"sv) {
+                        CheckBaseValue(event == Event::BOOL, key, "a bool"sv);
+                        result.is_roundtrip = parser.GetBool();
+                    }
+                    else if (key == "road_distances"sv) {
+                        CheckBaseValue(event == Event::START_DICT, key, "a dict"sv);
+                        for (event = parser.Next(); event != Event::END_DICT; event = parser.Next()) {
+                            const string_view stop = parser.GetString();
+                            CheckBaseValue(parser.Next() == Event::INT, key, "a dict of ints"sv);
+                            result.road_distances.emplace_back(stop, parser.GetInt());
+                        }
+                    }
+                    else if (key == "stops"sv) {
+                        CheckBaseValue(event == Event::START_ARRAY, key, "an array"sv);
+                        for (event = parser.Next(); event != Event::END_ARRAY; event = parser.Next()) {
+                            CheckBaseValue(event == Event::STRING, key, "an array of strings"sv);
+                            result.stops.push_back(parser.GetString());
+                        }
+                    }
+                    else {
+                        parser.Skip(event);
+                    }
+                }
+
+                return result;
+            }
+        }
+
+        void JsonReader::ReadBaseRequests(::json::Parser& parser, ::renderer::RequestHandler& rh) {
+            using Event = ::json::Parser::Event;
+
+            //Остановки добавляются сразу, дистанции и автобусы - когда известны все остановки
+            vector<tuple<string_view, string_view, uint64_t>> distances;
+            vector<BaseRequest> buses;
+
+            for (Event event = parser.Next(); event != Event::END_ARRAY; event = parser.Next()) {
+                if (event != Event::START_DICT) {
+                    throw ::json::ParsingError("Base request is not a dict"s);
+                }
+                BaseRequest request = ReadBaseRequest(parser);
+
+                if (request.type == "Bus"sv) {
+                    request.road_distances.clear();
+                    buses.push_back(move(request));
+                }
+                else if (request.type == "Stop"sv) {
+                    rh.AddStop(request.name, request.coordinates);
+                    for (const auto& [stop, distance] : request.road_distances) {
+                        distances.emplace_back(request.name, stop, distance);
+                    }
+                }
+            }
+
+            for (const auto& [from, to, distance] : distances) {
+                rh.AddDistance(from, to, distance);
+            }
+
+            for (const auto& bus : buses) {
+                rh.AddBus(bus.name, bus.stops, bus.is_roundtrip);
+            }
+        }
+
+        void JsonReader::ReadUpdateRequests(const ::json::Node& request, vector<QueryUpdate>& update_queries) {
             for (const auto& arr : request.AsArray()) {
                 const auto& req = arr.AsDict();
 
-                const string& base_requests_type = req.at("type"s).AsString();
+                QueryUpdate query;
+                query.type = req.at("type"s).AsString();
 
-                if (base_requests_type == "Bus"s) {
-                    QueryBus query;
-                    query.bus = req.at("name"s).AsString();
+                if (const auto action = req.find("action"s); action != req.end()) {
+                    query.is_remove = action->second.AsString() == "remove"s;
+                }
 
-                    for (const auto& stop : req.at("stops"s).AsArray()) {
-                        query.stops.emplace_back(stop.AsString());
-                    }
+                if (query.type == "Bus"s) {
+                    query.bus.bus = req.at("name"s).AsString();
 
-                    query.is_roundtrip = req.at("is_roundtrip"s).AsBool();
+                    if (!query.is_remove) {
+                        for (const auto& stop : req.at("stops"s).AsArray()) {
+                            query.bus.stops.emplace_back(stop.AsString());
+                        }
 
-                    bus_queries.emplace_back(move(query));
+                        query.bus.is_roundtrip = req.at("is_roundtrip"s).AsBool();
+                    }
                 }
-                else if (base_requests_type == "Stop"s) {
-                    QueryStop query;
+                else if (query.type == "Stop"s) {
+                    query.stop.stop = req.at("name"s).AsString();
 
-                    query.stop = req.at("name"s).AsString();
-                    query.coordinates.lat = req.at("latitude"s).AsDouble();
-                    query.coordinates.lng = req.at("longitude"s).AsDouble();
+                    if (req.count("latitude"s) > 0 && req.count("longitude"s) > 0) {
+                        query.has_coordinates = true;
+                        query.stop.coordinates.lat = req.at("latitude"s).AsDouble();
+                        query.stop.coordinates.lng = req.at("longitude"s).AsDouble();
+                    }
 
-                    for (const auto& [stop, distances] : req.at("road_distances"s).AsDict()) {
-                        query.distance_to_stop[stop] = distances.AsInt();
+                    if (const auto road_distances = req.find("road_distances"s); road_distances != req.end()) {
+                        for (const auto& [stop, distances] : road_distances->second.AsDict()) {
+                            query.stop.distance_to_stop[stop] = distances.AsInt();
+                        }
                     }
+                }
+                else if (query.type == "Distance"s) {
+                    query.from = req.at("from"s).AsString();
+                    query.to = req.at("to"s).AsString();
 
-                    stop_queries.emplace_back(move(query));
+                    if (!query.is_remove) {
+                        query.distance = req.at("distance"s).AsInt();
+                    }
+                }
+                else {
+                    continue;
                 }
+
+                update_queries.emplace_back(move(query));
             }
         }
 
@@ -70,58 +307,118 @@ namespace directory {
             }
         }
 
-        void JsonReader::ReadStatRequests(const ::json::Node& request, vector<QueryStat>& stat_queries) {
-            for (const auto& arr : request.AsArray()) {
-                const auto& req = arr.AsDict();
-                QueryStat query;
+        QueryStat JsonReader::ReadStatRequest(const ::json::Node& request) {
+            const auto& req = request.AsDict();
+            QueryStat query;
 
-                query.id = req.at("id"s).AsInt();
-                query.type = req.at("type"s).AsString();
+            query.id = req.at("id"sv).AsInt();
+            query.type = req.at("type"sv).AsString();
+
+            if (query.type == "Bus"sv || query.type == "Stop"sv) {
+                query.name = req.at("name"sv).AsString();
+            }
 
-                if (query.type == "Bus"s || query.type == "Stop"s) {
-                    query.name = req.at("name"s).AsString();
+            if (query.type == "Route"sv) {
+                //Начало и конец маршрута задаются названием остановки или координатами
+                if (const auto& from = req.at("from"sv); from.IsDict()) {
+                    query.from_point = ::geo::Coordinates{ from.AsDict().at("latitude"sv).AsDouble(), from.AsDict().at("longitude"sv).AsDouble() };
+                }
+                else {
+                    query.from = from.AsString();
                 }
 
-                if (query.type == "Route"s) {
-                    query.from = req.at("from"s).AsString();
-                    query.to = req.at("to"s).AsString();
+                if (const auto& to = req.at("to"sv); to.IsDict()) {
+                    query.to_point = ::geo::Coordinates{ to.AsDict().at("latitude"sv).AsDouble(), to.AsDict().at("longitude"sv).AsDouble() };
+                }
+                else {
+                    query.to = to.AsString();
+                }
+            }
+
+            if (query.type == "NearestStops"sv) {
+                query.coordinates.lat = req.at("latitude"sv).AsDouble();
+                query.coordinates.lng = req.at("longitude"sv).AsDouble();
+
+                if (req.count("count"sv) > 0) {
+                    //Отрицательное число после приведения к size_t стало бы снятием ограничения
+                    const int count = req.at("count"sv).AsInt();
+                    if (count <= 0) {
+                        throw ::json::ParsingError("NearestStops count must be positive"s);
+                    }
+                    query.count = static_cast<size_t>(count);
+                }
+                if (req.count("radius"sv) > 0) {
+                    query.radius = req.at("radius"sv).AsDouble();
+                }
+                //Без ограничений возвращается одна ближайшая остановка
+                if (query.count == 0 && query.radius == 0) {
+                    query.count = 1;
+                }
+            }
+
+            if (query.type == "StopSearch"sv) {
+                query.prefix = req.at("prefix"sv).AsString();
+                const int count = req.count("count"sv) > 0 ? req.at("count"sv).AsInt() : 10;
+                if (count < 0) {
+                    throw ::json::ParsingError("StopSearch count must not be negative"s);
                 }
+                query.count = static_cast<size_t>(count);
+            }
 
-                stat_queries.emplace_back(move(query));
+            if (query.type == "CommonBuses"sv || query.type == "CommonStops"sv) {
+                for (const auto& name : req.at(query.type == "CommonBuses"sv ? "stops"sv : "buses"sv).AsArray()) {
+                    query.names.emplace_back(name.AsString());
+                }
             }
+
+            return query;
         }
 
-        void JsonReader::ReadRoutingSettings(const ::json::Node& request, pair<int, double>& routing_settings) {
+        void JsonReader::ReadRoutingSettings(const ::json::Node& request, pair<int, double>& routing_settings, double& walk_velocity) {
             const auto& req = request.AsDict();
             routing_settings = { req.at("bus_wait_time"s).AsInt(), req.at("bus_velocity"s).AsDouble() };
+
+            if (req.count("walk_velocity"s) > 0) {
+                walk_velocity = req.at("walk_velocity"s).AsDouble();
+            }
         }
 
         void JsonReader::ReadSerializationSettings(const ::json::Node& request, string& path) {
             path = request.AsDict().at("file"s).AsString();
         }
 
-        void JsonReader::ReadMakeBase(istream& is, ::serialization_space::SerializeVariable& serialize_variable, string& path) {
+        bool JsonReader::ReadMakeBase(istream& is, ::serialization_space::SerializeVariable& serialize_variable, string& path, ::renderer::RequestHandler& rh) {
+            using Event = ::json::Parser::Event;
             try {
-                ::json::Document doc = ::json::Load(is);
+                //Текст разбирается на месте и живёт до конца чтения, названия из него копирует каталог
+                string text = ::json::ReadAll(is);
+                ::json::Parser parser(text);
 
-                const auto& requests = doc.GetRoot().AsDict();
-                for (const auto& [req_type, request] : requests) {
+                if (parser.Next() != Event::START_DICT) {
+                    throw ::json::ParsingError("Root is not a dict"s);
+                }
 
-                    if (req_type == "base_requests"s) {
-                        ReadBaseRequests(request, serialize_variable.bus_queries, serialize_variable.stop_queries);
+                for (Event event = parser.Next(); event != Event::END_DICT; event = parser.Next()) {
+                    const string req_type(parser.GetString());
+                    event = parser.Next();
+
+                    if (req_type == "base_requests"s && event == Event::START_ARRAY) {
+                        ReadBaseRequests(parser, rh);
+                        continue;
                     }
-                    else if (req_type == "render_settings"s) {
+
+                    const ::json::Node request = ::json::LoadNode(parser, event);
+                    if (req_type == "render_settings"s) {
                         ReadRenderSettings(request, serialize_variable.renderer);
                     }
                     else if (req_type == "routing_settings"s) {
-                        ReadRoutingSettings(request, serialize_variable.routing_settings);
+                        ReadRoutingSettings(request, serialize_variable.routing_settings, serialize_variable.walk_velocity);
                     }
                     else if (req_type == "serialization_settings"s) {
                         ReadSerializationSettings(request, path);
                     }
                 }
-
-                
+                return true;
             }
             catch (const std::exception& e) {
                 std::cerr << "exception thrown: "s << e.what() << std::endl;
@@ -129,21 +426,42 @@ namespace directory {
             catch (...) {
                 std::cerr << "Unexpected error"s << std::endl;
             }
+            return false;
+        }
+
+        bool JsonReader::ReadProcessRequests(std::istream& is, vector<QueryUpdate>& update_queries, string& path) {
+            return ReadProcessRequests(::json::ReadAll(is), update_queries, path);
         }
 
-        void JsonReader::ReadProcessRequests(std::istream& is, vector<QueryStat>& stat_queries, string& path) {
+        bool JsonReader::ReadProcessRequests(string input, vector<QueryUpdate>& update_queries, string& path) {
+            using Event = ::json::Parser::Event;
             try {
-                ::json::Document doc = ::json::Load(is);
+                input_ = move(input);
+                stat_requests_ = {};
+                ::json::Parser parser{ string_view(input_) };
+
+                if (parser.Next() != Event::START_DICT) {
+                    throw ::json::ParsingError("Root is not a dict"s);
+                }
+
+                for (Event event = parser.Next(); event != Event::END_DICT; event = parser.Next()) {
+                    const string req_type(parser.GetString());
+                    event = parser.Next();
 
-                const auto& requests = doc.GetRoot().AsDict();
-                for (const auto& [req_type, request] : requests) {
                     if (req_type == "stat_requests"s) {
-                        ReadStatRequests(request, stat_queries);
+                        stat_requests_ = parser.SkipRaw(event);
+                        continue;
+                    }
+
+                    const ::json::Node request = ::json::LoadNode(parser, event);
+                    if (req_type == "base_requests"s) {
+                        ReadUpdateRequests(request, update_queries);
                     }
                     else if (req_type == "serialization_settings"s) {
                         ReadSerializationSettings(request, path);
                     }
                 }
+                return true;
             }
             catch (const std::exception& e) {
                 std::cerr << "exception thrown: "s << e.what() << std::endl;
@@ -151,6 +469,8 @@ namespace directory {
             catch (...) {
                 std::cerr << "Unexpected error"s << std::endl;
             }
+            stat_requests_ = {};
+            return false;
         }
 
         ::svg::Color JsonReader::GetColor(const ::json::Node& node) {
@@ -171,181 +491,478 @@ namespace directory {
             return { "none" };
         }
 
-        void JsonReader::PrintStatRequests(::renderer::RequestHandler& rh, std::vector<QueryStat>& queries, std::ostream& os) {
-            ::json::Array out_array;
+        void JsonReader::PrintStatRequests(const ::renderer::RequestHandler& rh, std::ostream& os, ::json::Writer::Format format, ::thread_pool::ThreadPool* pool,
+            ::profiler::LatencyStats* latency) {
+            using Event = ::json::Parser::Event;
+            ::json::Writer writer(os, format);
 
-            for (const auto& query_out : queries) {
-                if (query_out.type == "Bus"s) {
-                    PrintBus(rh.GetInfoAboutRoute(query_out.name), query_out.id, out_array);
+            writer.StartArray();
+            try {
+                ::json::Parser parser(stat_requests_.empty() ? "[]"sv : stat_requests_);
+                if (parser.Next() != Event::START_ARRAY) {
+                    throw ::json::ParsingError("stat_requests is not an array"s);
                 }
 
-                if (query_out.type == "Stop"s) {
-                    bool contain_stop;
-                    set<string_view> buses;
-                    std::tie(contain_stop, buses) = rh.GetBusesForStop(query_out.name);
-                    PrintStop(contain_stop, buses, query_out.id, out_array);
+                PrintStatChunks(parser, rh.GetView(), writer, os, format, pool, latency);
+            }
+            catch (const std::exception& e) {
+                std::cerr << "exception thrown: "s << e.what() << std::endl;
+            }
+            writer.EndArray();
+        }
+
+        void JsonReader::PrintStatChunks(::json::Parser& parser, const ::renderer::BaseView& view, ::json::Writer& writer,
+            std::ostream& os, ::json::Writer::Format format, ::thread_pool::ThreadPool* pool, ::profiler::LatencyStats* latency) {
+            using Event = ::json::Parser::Event;
+            const size_t max_chunk_size = STAT_CHUNK_PER_THREAD * (pool != nullptr ? pool->GetThreadCount() : 1);
+            size_t chunk_size = min(FIRST_STAT_CHUNK, max_chunk_size);
+            const int indent = writer.GetValueIndent();
+
+            //Ответы на уже встречавшиеся запросы, ключ - MakeRequestKey
+            unordered_map<string, AnswerTemplate> cache;
+            size_t cache_size = 0;
+            bool is_dedup = true;
+            //Число просмотренных запросов и повторов среди них, пока решается, нужен ли поиск повторов
+            size_t probed = 0;
+            size_t hits = 0;
+
+            vector<QueryStat> queries;
+            vector<string> keys;
+            //Номер запроса части, ответ которого выводится; CACHED - ответ уже есть в cache
+            vector<size_t> sources;
+            vector<const AnswerTemplate*> templates;
+            //Запросы, ответы на которые нужно сформировать, и эти ответы
+            vector<size_t> computed;
+            vector<string> answers;
+            vector<exception_ptr> errors;
+            unordered_map<string_view, size_t> first_in_chunk;
+            //Запросы (номера в computed), которые выполняются вместе, и группы Route по началу маршрута
+            vector<vector<size_t>> units;
+            unordered_map<string, size_t> route_groups;
+            string answer;
+            //Потоки записывают время запросов в свои гистограммы и добавляют их сюда в конце работы
+            mutex latency_mutex;
+            queries.reserve(max_chunk_size);
+
+            for (bool is_end = false; !is_end;) {
+                //Запросы читаются частями, чтобы ответы не накапливались в памяти
+                queries.clear();
+                exception_ptr read_error;
+                try {
+                    while (queries.size() < chunk_size) {
+                        const Event event = parser.Next();
+                        if (event == Event::END_ARRAY) {
+                            is_end = true;
+                            break;
+                        }
+                        queries.push_back(ReadStatRequest(::json::LoadNode(parser, event)));
+                    }
+                }
+                catch (...) {
+                    read_error = current_exception();
+                    is_end = true;
                 }
 
-                if (query_out.type == "Map"s) {
-                    PrintMap(rh.RenderMap(), query_out.id, out_array);
+                //Одинаковые запросы с разными id выполняются один раз
+                keys.resize(queries.size());
+                sources.assign(queries.size(), CACHED);
+                templates.assign(queries.size(), nullptr);
+                computed.clear();
+                first_in_chunk.clear();
+                for (size_t i = 0; i < queries.size(); ++i) {
+                    if (!is_dedup) {
+                        sources[i] = i;
+                        computed.push_back(i);
+                        continue;
+                    }
+                    keys[i] = MakeRequestKey(queries[i]);
+                    if (const auto it = cache.find(keys[i]); it != cache.end()) {
+                        templates[i] = &it->second;
+                        continue;
+                    }
+                    const auto [it, is_first] = first_in_chunk.emplace(keys[i], i);
+                    sources[i] = it->second;
+                    if (is_first) {
+                        computed.push_back(i);
+                    }
                 }
 
-                if (query_out.type == "Route"s) {
-                    PrintRoute(query_out, out_array, rh);
+                //Запросы Route с одинаковым началом выполняются вместе, одним поиском по графу
+                units.clear();
+                route_groups.clear();
+                for (size_t j = 0; j < computed.size(); ++j) {
+                    const QueryStat& query = queries[computed[j]];
+                    if (query.type == "Route"sv) {
+                        const auto [it, is_new] = route_groups.emplace(MakeOriginKey(query), units.size());
+                        if (!is_new) {
+                            units[it->second].push_back(j);
+                            continue;
+                        }
+                    }
+                    units.push_back({ j });
                 }
-            }
 
-            json::Print(
-                json::Document{
-                    json::Builder{}
-                    .Value(out_array)
-                    .Build()
-                },
-                os
-            );
+                answers.assign(computed.size(), string());
+                errors.assign(computed.size(), nullptr);
+
+                //Каждый поток выводит ответы в свой поток вывода с форматом чисел os.
+                //Замерять ли время, решается один раз на вызов, без замеров в коде запросов нет даже проверок
+                const auto compute_units = [&](auto timer_type, size_t begin, size_t end) {
+                    using Timer = typename decltype(timer_type)::Type;
+                    constexpr bool is_timed = !is_same_v<Timer, ::profiler::NoRequestTimer>;
+                    ostringstream out;
+                    out.copyfmt(os);
+                    ::profiler::LatencyStats local_latency;
+                    ::profiler::LatencyStats* const thread_latency = is_timed ? &local_latency : nullptr;
+                    const auto render = [&](size_t j, const auto& print) {
+                        out.str(string());
+                        try {
+                            ::json::Writer answer_writer(out, format, indent);
+                            print(answer_writer);
+                        }
+                        catch (...) {
+                            errors[j] = current_exception();
+                        }
+                        answers[j] = out.str();
+                    };
+
+                    vector<const QueryStat*> route_queries;
+                    for (size_t u = begin; u < end; ++u) {
+                        const vector<size_t>& unit = units[u];
+                        const QueryStat& query = queries[computed[unit.front()]];
+                        if (query.type != "Route"sv) {
+                            render(unit.front(), [&](::json::Writer& answer_writer) { PrintStatRequest<Timer>(query, answer_writer, view, thread_latency); });
+                            continue;
+                        }
+
+                        route_queries.clear();
+                        for (size_t j : unit) {
+                            route_queries.push_back(&queries[computed[j]]);
+                        }
+
+                        vector<::transport_router::TransportRouter::RouteInfo> routes;
+                        const auto search_start = is_timed ? Clock::now() : Clock::time_point();
+                        try {
+                            routes = view.GetRoutesForQueries(route_queries);
+                        }
+                        catch (...) {
+                            for (size_t j : unit) {
+                                errors[j] = current_exception();
+                            }
+                            continue;
+                        }
+                        //Время общего поиска делится поровну между запросами группы
+                        const auto search_time = is_timed ? (Clock::now() - search_start) / static_cast<Clock::rep>(unit.size()) : Clock::duration(0);
+
+                        for (size_t k = 0; k < unit.size(); ++k) {
+                            render(unit[k], [&](::json::Writer& answer_writer) {
+                                Timer timer(thread_latency, query.type);
+                                timer.MarkExecuted();
+                                PrintRoute(*route_queries[k], routes[k], answer_writer);
+                                timer.Finish(search_time);
+                            });
+                        }
+                    }
+
+                    if constexpr (is_timed) {
+                        lock_guard lock(latency_mutex);
+                        latency->Merge(local_latency);
+                    }
+                };
+                const auto compute = [&](size_t begin, size_t end) {
+                    if (latency == nullptr) {
+                        compute_units(TimerType<::profiler::NoRequestTimer>{}, begin, end);
+                    }
+                    else {
+                        compute_units(TimerType<::profiler::RequestTimer>{}, begin, end);
+                    }
+                };
+                if (pool != nullptr) {
+                    pool->ParallelFor(units.size(), compute);
+                }
+                else {
+                    compute(0, units.size());
+                }
+
+                //Ответы выводятся в порядке запросов, до первой ошибки - как при последовательной обработке
+                for (size_t i = 0, next_computed = 0; i < queries.size(); ++i) {
+                    if (sources[i] == i) {
+                        if (errors[next_computed]) {
+                            rethrow_exception(errors[next_computed]);
+                        }
+                        string& computed_answer = answers[next_computed++];
+                        if (!computed_answer.empty()) {
+                            writer.RawValue(computed_answer);
+                        }
+                        if (!is_dedup) {
+                            continue;
+                        }
+                        //first_in_chunk больше не нужен, ключ можно перенести в кэш
+                        cache_size += computed_answer.size() + keys[i].size();
+                        templates[i] = &cache.emplace(move(keys[i]), MakeAnswerTemplate(move(computed_answer))).first->second;
+                        continue;
+                    }
+
+                    //Элементы unordered_map не перемещаются при вставке, указатели на шаблоны остаются верными
+                    const AnswerTemplate& answer_template = *templates[sources[i] == CACHED ? i : sources[i]];
+                    if (answer_template.text.empty()) {
+                        continue;
+                    }
+                    //Повторный запрос не выполняется, его вывод - подстановка id в готовый ответ
+                    const auto fill_start = latency != nullptr ? Clock::now() : Clock::time_point();
+                    writer.RawValue(FillAnswerTemplate(answer_template, queries[i].id, answer));
+                    if (latency != nullptr) {
+                        latency->Record(queries[i].type, Clock::duration(0), Clock::now() - fill_start);
+                    }
+                }
+                //Ответы части сразу уходят в поток, а не ждут заполнения буфера Writer или конца пакета
+                writer.Flush();
+                os.flush();
+
+                if (is_dedup && probed < DEDUP_PROBE_SIZE) {
+                    probed += queries.size();
+                    hits += queries.size() - computed.size();
+                    if (probed >= DEDUP_PROBE_SIZE && hits * DEDUP_MIN_HIT_RATE < probed) {
+                        is_dedup = false;
+                        cache.clear();
+                        cache_size = 0;
+                    }
+                }
+
+                //Кэш ограничен по размеру: переполненный очищается целиком между частями
+                if (cache_size > DEDUP_CACHE_SIZE) {
+                    cache.clear();
+                    cache_size = 0;
+                }
+
+                if (read_error) {
+                    rethrow_exception(read_error);
+                }
+                chunk_size = min(chunk_size * 2, max_chunk_size);
+            }
         }
 
-        void JsonReader::PrintRoute(const QueryStat& query_out, ::json::Array& out_array, ::renderer::RequestHandler& rh) {
+        template <typename Timer>
+        void JsonReader::PrintStatRequest(const QueryStat& query_out, ::json::Writer& writer, const ::renderer::BaseView& view, ::profiler::LatencyStats* latency) {
+            Timer timer(latency, query_out.type);
 
-            ::transport_router::TransportRouter::RouteInfo route = rh.GetRouteForQuery(query_out);
+            if (query_out.type == "Bus"sv) {
+                const Bus* bus = view.GetInfoAboutRoute(query_out.name);
+                timer.MarkExecuted();
+                PrintBus(bus, query_out.id, writer);
+            }
 
+            if (query_out.type == "Stop"sv) {
+                const auto [contain_stop, buses] = view.GetBusesForStop(query_out.name);
+                timer.MarkExecuted();
+                PrintStop(contain_stop, buses, query_out.id, writer);
+            }
+
+            if (query_out.type == "Map"sv) {
+                const svg::Document doc = view.RenderMap();
+                timer.MarkExecuted();
+                PrintMap(doc, query_out.id, writer);
+            }
+
+            if (query_out.type == "Route"sv) {
+                const auto route = view.GetRouteForQuery(query_out);
+                timer.MarkExecuted();
+                PrintRoute(query_out, route, writer);
+            }
+
+            if (query_out.type == "NearestStops"sv) {
+                const auto stops = view.GetNearestStops(query_out);
+                timer.MarkExecuted();
+                PrintNearestStops(query_out, stops, writer);
+            }
+
+            if (query_out.type == "StopSearch"sv) {
+                const auto stops = view.GetStopsByPrefix(query_out);
+                timer.MarkExecuted();
+                PrintStopSearch(query_out, stops, writer);
+            }
+
+            if (query_out.type == "CommonBuses"sv || query_out.type == "CommonStops"sv) {
+                const auto names = query_out.type == "CommonBuses"sv ? view.GetCommonBuses(query_out) : view.GetCommonStops(query_out);
+                timer.MarkExecuted();
+                PrintCommon(query_out, names, writer);
+            }
+
+            timer.Finish();
+        }
+
+        void JsonReader::PrintRoute(const QueryStat& query_out, const ::transport_router::TransportRouter::RouteInfo& route, ::json::Writer& writer) {
             if (route.total_time < 0) {
-                PrintNotFoundRoute(query_out, out_array);
+                PrintNotFound(query_out.id, writer);
+                return;
             }
-            else {
-                ::json::Array items_array;
-                for (const auto& edge_info : route.edges) {
-
-                    if (!edge_info->is_bus_type) {
-                        ::json::Node node{
-                            json::Builder{}
-                                .StartDict()
-                                    .Key("stop_name"s).Value(edge_info->stop_name)
-                                    .Key("time"s).Value(edge_info->time)
-                                    .Key("type"s).Value("Wait"s)
-                                .EndDict()
-                            .Build()
-                        };
-
-                        items_array.emplace_back(move(node));
-                    }
-                    else if (edge_info->is_bus_type) {
-                        ::json::Node node{
-                            json::Builder{}
-                                .StartDict()
-                                    .Key("bus"s).Value(edge_info->bus)
-                                    .Key("span_count"s).Value(edge_info->span_count)
-                                    .Key("time"s).Value(edge_info->time)
-                                    .Key("type"s).Value("Bus"s)
-                                .EndDict()
-                            .Build()
-                        };
-
-                        items_array.emplace_back(move(node));
-                    }
-                }
-
-                ::json::Node node{
-                    json::Builder{}
+
+            writer.StartDict().Key("items"sv).StartArray();
+
+            //Пеший участок от точки до первой остановки
+            if (query_out.from_point) {
+                PrintWalk(route.walk_from.value(), writer);
+            }
+
+            for (const auto& edge_info : route.edges) {
+
+                if (!edge_info->is_bus_type) {
+                    writer
                         .StartDict()
-                            .Key("items"s).Value(items_array)
-                            .Key("request_id"s).Value(query_out.id)
-                            .Key("total_time"s).Value(route.total_time)
-                        .EndDict()
-                    .Build()
-                };
+                            .Key("stop_name"sv).Value(edge_info->stop_name)
+                            .Key("time"sv).Value(edge_info->time)
+                            .Key("type"sv).Value("Wait"sv)
+                        .EndDict();
+                }
+                else if (edge_info->is_bus_type) {
+                    writer
+                        .StartDict()
+                            .Key("bus"sv).Value(edge_info->bus)
+                            .Key("span_count"sv).Value(edge_info->span_count)
+                            .Key("time"sv).Value(edge_info->time)
+                            .Key("type"sv).Value("Bus"sv)
+                        .EndDict();
+                }
+            }
 
-                out_array.emplace_back(move(node));
+            //Пеший участок от последней остановки до точки
+            if (query_out.to_point) {
+                PrintWalk(route.walk_to.value(), writer);
             }
+
+            writer
+                .EndArray()
+                .Key("request_id"sv).Value(query_out.id)
+                .Key("total_time"sv).Value(route.total_time)
+            .EndDict();
         }
 
-        void JsonReader::PrintNotFoundRoute(const QueryStat& query_out, ::json::Array& out_array) {
-            ::json::Node node{
-                json::Builder{}
-                    .StartDict()
-                        .Key("error_message"s).Value("not found"s)
-                        .Key("request_id"s).Value(query_out.id)
-                    .EndDict()
-                .Build()
-            };
-            out_array.emplace_back(move(node));
+        void JsonReader::PrintWalk(const ::transport_router::TransportRouter::WalkInfo& walk, ::json::Writer& writer) {
+            writer
+                .StartDict()
+                    .Key("stop_name"sv).Value(walk.stop_name)
+                    .Key("time"sv).Value(walk.time)
+                    .Key("type"sv).Value("Walk"sv)
+                .EndDict();
         }
 
-        void JsonReader::PrintMap(svg::Document doc, int id, ::json::Array& out_array) {
-            std::stringstream out;
-            doc.Render(out);
+        void JsonReader::PrintNotFound(int id, ::json::Writer& writer) {
+            writer
+                .StartDict()
+                    .Key("error_message"sv).Value("not found"sv)
+                    .Key("request_id"sv).Value(id)
+                .EndDict();
+        }
+
+        void JsonReader::PrintNearestStops(const QueryStat& query_out, const vector<pair<string_view, double>>& stops, ::json::Writer& writer) {
+            writer
+                .StartDict()
+                    .Key("request_id"sv).Value(query_out.id)
+                    .Key("stops"sv).StartArray();
 
-            ::json::Node node{
-                json::Builder{}
+            for (const auto& [stop_name, distance] : stops) {
+                writer
                     .StartDict()
-                        .Key("map"s).Value(out.str())
-                        .Key("request_id"s).Value(id)
-                    .EndDict()
-                .Build()
-            };
+                        .Key("distance"sv).Value(distance)
+                        .Key("stop_name"sv).Value(stop_name)
+                    .EndDict();
+            }
 
-            out_array.emplace_back(move(node));
+            writer.EndArray().EndDict();
         }
 
-        void JsonReader::PrintStop(bool contain_stop, std::set<std::string_view>& buses, int id, ::json::Array& out_array) {
-            if (!contain_stop) {
+        void JsonReader::PrintStopSearch(const QueryStat& query_out, const vector<pair<string_view, set<string_view>>>& stops,
+            ::json::Writer& writer) {
+            writer
+                .StartDict()
+                    .Key("request_id"sv).Value(query_out.id)
+                    .Key("stops"sv).StartArray();
+
+            for (const auto& [stop_name, buses] : stops) {
+                writer.StartDict().Key("buses"sv).StartArray();
+                for (string_view bus : buses) {
+                    writer.Value(bus);
+                }
+                writer
+                        .EndArray()
+                        .Key("stop_name"sv).Value(stop_name)
+                    .EndDict();
+            }
 
-                ::json::Node node{
-                    json::Builder{}
-                        .StartDict()
-                            .Key("request_id"s).Value(id)
-                            .Key("error_message"s).Value("not found"s)
-                        .EndDict()
-                    .Build()
-                };
+            writer.EndArray().EndDict();
+        }
+
+        void JsonReader::PrintCommon(const QueryStat& query_out, const optional<vector<string_view>>& names, ::json::Writer& writer) {
+            const bool is_buses = query_out.type == "CommonBuses"sv;
 
-                out_array.emplace_back(move(node));
+            if (!names) {
+                PrintNotFound(query_out.id, writer);
+                return;
             }
-            else {
-                std::vector<std::string> temp{ buses.begin(), buses.end() };
 
-                ::json::Node node{
-                    json::Builder{}
-                        .StartDict()
-                            .Key("buses"s).Value(::json::Array{temp.begin(), temp.end()})
-                            .Key("request_id"s).Value(id)
-                        .EndDict()
-                    .Build()
-                };
+            auto print_names = [&writer, &names]() {
+                writer.StartArray();
+                for (string_view name : *names) {
+                    writer.Value(name);
+                }
+                writer.EndArray();
+            };
 
-                out_array.emplace_back(move(node));
+            //Ключи по алфавиту: "buses" < "request_id" < "stops"
+            writer.StartDict();
+            if (is_buses) {
+                writer.Key("buses"sv);
+                print_names();
+                writer.Key("request_id"sv).Value(query_out.id);
+            }
+            else {
+                writer.Key("request_id"sv).Value(query_out.id).Key("stops"sv);
+                print_names();
             }
+            writer.EndDict();
         }
 
-        void JsonReader::PrintBus(Bus* bus, int id, ::json::Array& out_array) {
-            if (bus->stops_on_route != 0) {
-                ::json::Node node{
-                    json::Builder{}
-                        .StartDict()
-                            .Key("curvature"s).Value(bus->curvature)
-                            .Key("request_id"s).Value(id)
-                            .Key("route_length"s).Value(static_cast<double>(bus->route_length))
-                            .Key("stop_count"s).Value(static_cast<int>(bus->stops_on_route))
-                            .Key("unique_stop_count"s).Value(static_cast<int>(bus->unique_stops))
-                        .EndDict()
-                    .Build()
-                };
+        void JsonReader::PrintMap(const svg::Document& doc, int id, ::json::Writer& writer) {
+            std::stringstream out;
+            doc.Render(out);
 
-                out_array.emplace_back(move(node));
+            writer
+                .StartDict()
+                    .Key("map"sv).Value(out.str())
+                    .Key("request_id"sv).Value(id)
+                .EndDict();
+        }
+
+        void JsonReader::PrintStop(bool contain_stop, const std::set<std::string_view>& buses, int id, ::json::Writer& writer) {
+            if (!contain_stop) {
+                PrintNotFound(id, writer);
+                return;
             }
-            else {
 
-                ::json::Node node{
-                    json::Builder{}
-                        .StartDict()
-                            .Key("request_id"s).Value(id)
-                            .Key("error_message"s).Value("not found"s)
-                        .EndDict()
-                    .Build()
-                };
+            writer.StartDict().Key("buses"sv).StartArray();
+            for (string_view bus : buses) {
+                writer.Value(bus);
+            }
+            writer
+                    .EndArray()
+                    .Key("request_id"sv).Value(id)
+                .EndDict();
+        }
 
-                out_array.emplace_back(move(node));
+        void JsonReader::PrintBus(const Bus* bus, int id, ::json::Writer& writer) {
+            if (bus->stops_on_route == 0) {
+                PrintNotFound(id, writer);
+                return;
             }
+
+            writer
+                .StartDict()
+                    .Key("curvature"sv).Value(bus->curvature)
+                    .Key("request_id"sv).Value(id)
+                    .Key("route_length"sv).Value(static_cast<double>(bus->route_length))
+                    .Key("stop_count"sv).Value(static_cast<int>(bus->stops_on_route))
+                    .Key("unique_stop_count"sv).Value(static_cast<int>(bus->unique_stops))
+                .EndDict();
         }
     }// json_detail
 } //namespace directory
\ No newline at end of file
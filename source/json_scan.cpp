@@ -0,0 +1,113 @@
+#include "json_scan.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define JSON_SCAN_SSE2
+#endif
+
+namespace json {
+
+    namespace {
+        const size_t CHUNK_SIZE = 16;
+
+        bool IsSpecialChar(char c) {
+            return c == '"' || c == '\\' || c == '\n' || c == '\r';
+        }
+
+#ifdef JSON_SCAN_SSE2
+        //Есть ли особый символ среди 16 байт, начиная с data
+        bool HasSpecialChar(const char* data) {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            const __m128i found = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))),
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'))));
+            return _mm_movemask_epi8(found) != 0;
+        }
+#endif
+
+        //Запись символа с экранированием, возвращается позиция после записанного
+        char* EscapeChar(char* out, char c) {
+            switch (c) {
+            case '\n':
+                *out++ = '\\';
+                *out++ = 'n';
+                break;
+            case '\r':
+                *out++ = '\\';
+                *out++ = 'r';
+                break;
+            case '"':
+            case '\\':
+                *out++ = '\\';
+                *out++ = c;
+                break;
+            default:
+                *out++ = c;
+                break;
+            }
+            return out;
+        }
+    }
+
+    const char* FindSpecialChar(const char* begin, const char* end) {
+#ifdef JSON_SCAN_SSE2
+        //Найденный символ точно лежит среди последних проверенных 16 байт, их дочитывает цикл ниже
+        while (static_cast<size_t>(end - begin) >= CHUNK_SIZE && !HasSpecialChar(begin)) {
+            begin += CHUNK_SIZE;
+        }
+#endif
+        while (begin != end && !IsSpecialChar(*begin)) {
+            ++begin;
+        }
+        return begin;
+    }
+
+    void AppendEscaped(std::string& out, std::string_view value) {
+        const char* pos = value.data();
+        const char* const end = value.data() + value.size();
+        while (pos != end) {
+            const char* const special = FindSpecialChar(pos, end);
+            out.append(pos, special);
+            if (special == end) {
+                break;
+            }
+
+            char escaped[2];
+            out.append(escaped, EscapeChar(escaped, *special) - escaped);
+            pos = special + 1;
+        }
+    }
+
+    void PrintEscaped(std::string_view value, std::ostream& out) {
+        char buffer[4096];
+        size_t size = 0;
+
+        const char* pos = value.data();
+        const char* const end = value.data() + value.size();
+        while (pos != end) {
+            const char* const special = FindSpecialChar(pos, end);
+            const size_t run = special - pos;
+
+            //Участок без особых символов копируется целиком, длинный выводится напрямую
+            if (size + run + 2 > sizeof(buffer)) {
+                out.write(buffer, size);
+                size = 0;
+            }
+            if (run + 2 > sizeof(buffer)) {
+                out.write(pos, run);
+            }
+            else {
+                std::memcpy(buffer + size, pos, run);
+                size += run;
+            }
+
+            pos = special;
+            if (pos != end) {
+                size = EscapeChar(buffer + size, *pos++) - buffer;
+            }
+        }
+        out.write(buffer, size);
+    }
+}
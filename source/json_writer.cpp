@@ -0,0 +1,196 @@
+#include "json_writer.h"
+#include "json.h"
+#include "json_scan.h"
+
+#include <stdexcept>
+
+using namespace std::literals;
+
+namespace json {
+
+    namespace {
+        const int INDENT_STEP = 4;
+
+        //Размер буфера, после которого он выводится в поток
+        const size_t BUFFER_SIZE = 1 << 16;
+    }
+
+    Writer::Writer(std::ostream& out, Format format, int indent)
+        : out_(out)
+        , format_(format)
+        , indent_(indent) {
+        buffer_.reserve(BUFFER_SIZE);
+    }
+
+    Writer::~Writer() {
+        Flush();
+    }
+
+    Writer& Writer::Key(std::string_view key) {
+        if (stack_.empty() || !stack_.back().is_dict || is_key_written_) {
+            throw std::logic_error("Key is not expected"s);
+        }
+
+        Container& dict = stack_.back();
+        if (!dict.is_empty) {
+            buffer_.push_back(',');
+        }
+        dict.is_empty = false;
+        WriteNewLine(stack_.size());
+        WriteString(key);
+        buffer_ += format_ == Format::PRETTY ? ": "sv : ":"sv;
+        is_key_written_ = true;
+
+        return *this;
+    }
+
+    Writer& Writer::Value(std::nullptr_t) {
+        BeforeValue();
+        buffer_ += "null"sv;
+        return *this;
+    }
+
+    Writer& Writer::Value(bool value) {
+        BeforeValue();
+        buffer_ += value ? "true"sv : "false"sv;
+        return *this;
+    }
+
+    Writer& Writer::Value(int value) {
+        BeforeValue();
+        char number[16];
+        buffer_.append(number, FormatNumber(value, number, number + sizeof(number)) - number);
+        return *this;
+    }
+
+    Writer& Writer::Value(double value) {
+        BeforeValue();
+        char number[64];
+        if (const char* number_end = FormatNumber(value, out_, number, number + sizeof(number))) {
+            buffer_.append(number, number_end - number);
+        }
+        else {
+            //Особый формат потока: число выводит сам поток
+            Flush();
+            out_ << value;
+        }
+        return *this;
+    }
+
+    Writer& Writer::Value(std::string_view value) {
+        BeforeValue();
+        WriteString(value);
+        return *this;
+    }
+
+    Writer& Writer::Value(const char* value) {
+        return Value(std::string_view(value));
+    }
+
+    Writer& Writer::StartDict() {
+        BeforeValue();
+        buffer_.push_back('{');
+        stack_.push_back({ true });
+        return *this;
+    }
+
+    Writer& Writer::StartArray() {
+        BeforeValue();
+        buffer_.push_back('[');
+        stack_.push_back({ false });
+        return *this;
+    }
+
+    Writer& Writer::EndDict() {
+        EndContainer(true);
+        buffer_.push_back('}');
+        FlushIfFull();
+        return *this;
+    }
+
+    Writer& Writer::EndArray() {
+        EndContainer(false);
+        buffer_.push_back(']');
+        FlushIfFull();
+        return *this;
+    }
+
+    Writer& Writer::RawValue(std::string_view json) {
+        BeforeValue();
+        buffer_ += json;
+        FlushIfFull();
+        return *this;
+    }
+
+    size_t Writer::GetDepth() const {
+        return stack_.size();
+    }
+
+    int Writer::GetValueIndent() const {
+        return format_ == Format::PRETTY ? indent_ + static_cast<int>(stack_.size()) * INDENT_STEP : 0;
+    }
+
+    void Writer::Flush() {
+        out_.write(buffer_.data(), buffer_.size());
+        buffer_.clear();
+    }
+
+    void Writer::FlushIfFull() {
+        if (buffer_.size() >= BUFFER_SIZE) {
+            Flush();
+        }
+    }
+
+    void Writer::BeforeValue() {
+        if (stack_.empty()) {
+            if (is_root_written_) {
+                throw std::logic_error("Root value is already written"s);
+            }
+            is_root_written_ = true;
+            return;
+        }
+
+        Container& container = stack_.back();
+        if (container.is_dict) {
+            if (!is_key_written_) {
+                throw std::logic_error("Value without key"s);
+            }
+            is_key_written_ = false;
+            return;
+        }
+
+        if (!container.is_empty) {
+            buffer_.push_back(',');
+        }
+        container.is_empty = false;
+        WriteNewLine(stack_.size());
+    }
+
+    void Writer::EndContainer(bool is_dict) {
+        if (stack_.empty() || stack_.back().is_dict != is_dict || is_key_written_) {
+            throw std::logic_error(is_dict ? "EndDict is not expected"s : "EndArray is not expected"s);
+        }
+
+        //json::Print и пустой контейнер выводит на отдельных строках
+        if (stack_.back().is_empty && format_ == Format::PRETTY) {
+            buffer_.push_back('\n');
+        }
+        stack_.pop_back();
+        WriteNewLine(stack_.size());
+    }
+
+    void Writer::WriteNewLine(size_t depth) {
+        if (format_ == Format::COMPACT) {
+            return;
+        }
+        buffer_.push_back('\n');
+        buffer_.append(indent_ + depth * INDENT_STEP, ' ');
+    }
+
+    void Writer::WriteString(std::string_view value) {
+        buffer_.push_back('"');
+        AppendEscaped(buffer_, value);
+        buffer_.push_back('"');
+        FlushIfFull();
+    }
+}
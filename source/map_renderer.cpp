@@ -4,7 +4,7 @@ namespace map_renderer {
 
 	using namespace std;
 
-	DrawRoute::DrawRoute(deque<pair<::directory::Bus*, vector<string_view>>>& buses_with_stops, set<string>& all_stops, deque<::geo::Coordinates>& coordinates,
+	DrawRoute::DrawRoute(deque<pair<const ::directory::Bus*, vector<string_view>>>& buses_with_stops, set<string>& all_stops, deque<::geo::Coordinates>& coordinates,
 						 const map_renderer::MapRenderer& renderer, unordered_map<string_view, ::geo::Coordinates>& stops_with_coordinates)
 		: all_stops_(all_stops)
 		, buses_with_stops_(buses_with_stops)
@@ -64,7 +64,7 @@ namespace map_renderer {
 					.SetFontSize(renderer_.bus_label_font_size)
 					.SetFontFamily("Verdana")
 					.SetFontWeight("bold")
-					.SetData(bus->bus_name);
+					.SetData(string(bus->bus_name));
 
 				name_bus_ground
 					.SetFillColor(renderer_.underlayer_color)
@@ -77,7 +77,7 @@ namespace map_renderer {
 					.SetFontSize(renderer_.bus_label_font_size)
 					.SetFontFamily("Verdana")
 					.SetFontWeight("bold")
-					.SetData(bus->bus_name);
+					.SetData(string(bus->bus_name));
 
 
 				doc.Add(name_bus_ground);
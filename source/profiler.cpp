@@ -0,0 +1,254 @@
+#include "profiler.h"
+#include "json_writer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace profiler {
+
+    using namespace std;
+
+    namespace {
+        const size_t SUB_BUCKET_BITS = LatencyHistogram::SUB_BUCKET_BITS;
+        const size_t SUB_BUCKETS = LatencyHistogram::SUB_BUCKETS;
+        //Значения меньше SUB_BUCKETS записываются точно, дальше - по SUB_BUCKETS корзин на каждую степень двойки
+        const size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+        //Номер старшего единичного бита, value > 0
+        size_t GetHighestBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+            return 63 - static_cast<size_t>(__builtin_clzll(value));
+#else
+            size_t bit = 0;
+            while (value >>= 1) {
+                ++bit;
+            }
+            return bit;
+#endif
+        }
+
+        size_t GetBucketIndex(uint64_t value) {
+            if (value < SUB_BUCKETS) {
+                return static_cast<size_t>(value);
+            }
+            const size_t shift = GetHighestBit(value) - SUB_BUCKET_BITS;
+            return (shift + 1) * SUB_BUCKETS + static_cast<size_t>(value >> shift) - SUB_BUCKETS;
+        }
+
+        //Наибольшее значение, попадающее в корзину
+        uint64_t GetBucketUpperBound(size_t index) {
+            if (index < SUB_BUCKETS) {
+                return index;
+            }
+            const size_t shift = index / SUB_BUCKETS - 1;
+            const uint64_t sub_bucket = SUB_BUCKETS + index % SUB_BUCKETS;
+            return ((sub_bucket + 1) << shift) - 1;
+        }
+
+        //Целые числа отчёта не помещаются в int, который принимает Writer::Value
+        template <typename Number>
+        void WriteNumber(::json::Writer& writer, Number value) {
+            writer.RawValue(to_string(value));
+        }
+    }
+
+    size_t GetPeakRss() {
+#if defined(__unix__) || defined(__APPLE__)
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) != 0) {
+            return 0;
+        }
+#if defined(__APPLE__)
+        //В macOS размер в байтах
+        return static_cast<size_t>(usage.ru_maxrss) / 1024;
+#else
+        return static_cast<size_t>(usage.ru_maxrss);
+#endif
+#else
+        return 0;
+#endif
+    }
+
+    void PhaseProfiler::AddPhase(string_view name, chrono::nanoseconds duration) {
+        auto phase = find_if(phases_.begin(), phases_.end(), [name](const Phase& phase) { return phase.name == name; });
+        if (phase == phases_.end()) {
+            phase = phases_.insert(phases_.end(), Phase{ string(name) });
+        }
+
+        ++phase->count;
+        phase->duration += duration;
+        phase->peak_rss = GetPeakRss();
+    }
+
+    const vector<PhaseProfiler::Phase>& PhaseProfiler::GetPhases() const {
+        return phases_;
+    }
+
+    void PhaseProfiler::Print(string_view mode, ostream& out) const {
+        const chrono::nanoseconds total = chrono::steady_clock::now() - start_;
+
+        //Названия этапов и режим экранируются Writer, отчёт всегда остаётся корректным JSON
+        {
+            ::json::Writer writer(out, ::json::Writer::Format::COMPACT);
+            writer.StartDict().Key("mode"sv).Value(mode).Key("phases"sv).StartArray();
+            for (const Phase& phase : phases_) {
+                writer.StartDict().Key("name"sv).Value(phase.name).Key("count"sv);
+                WriteNumber(writer, phase.count);
+                writer.Key("ns"sv);
+                WriteNumber(writer, phase.duration.count());
+                writer.Key("peak_rss_kb"sv);
+                WriteNumber(writer, phase.peak_rss);
+                writer.EndDict();
+            }
+            writer.EndArray().Key("total_ns"sv);
+            WriteNumber(writer, total.count());
+            writer.Key("peak_rss_kb"sv);
+            WriteNumber(writer, GetPeakRss());
+            writer.EndDict();
+        }
+        out << '\n';
+    }
+
+    ScopedPhase::ScopedPhase(PhaseProfiler& profiler, string_view name)
+        : profiler_(profiler)
+        , name_(name)
+        , start_(chrono::steady_clock::now()) {
+    }
+
+    ScopedPhase::~ScopedPhase() {
+        profiler_.AddPhase(name_, chrono::steady_clock::now() - start_);
+    }
+
+    void LatencyHistogram::Record(chrono::nanoseconds duration) {
+        const uint64_t value = static_cast<uint64_t>(max<chrono::nanoseconds::rep>(duration.count(), 0));
+        if (counts_.empty()) {
+            counts_.assign(BUCKET_COUNT, 0);
+        }
+        ++counts_[GetBucketIndex(value)];
+        ++count_;
+        max_ = std::max(max_, value);
+    }
+
+    void LatencyHistogram::Merge(const LatencyHistogram& other) {
+        if (other.count_ == 0) {
+            return;
+        }
+        if (counts_.empty()) {
+            counts_.assign(BUCKET_COUNT, 0);
+        }
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        count_ += other.count_;
+        max_ = std::max(max_, other.max_);
+    }
+
+    uint64_t LatencyHistogram::GetCount() const {
+        return count_;
+    }
+
+    chrono::nanoseconds LatencyHistogram::GetMax() const {
+        return chrono::nanoseconds(max_);
+    }
+
+    chrono::nanoseconds LatencyHistogram::GetPercentile(double quantile) const {
+        if (count_ == 0) {
+            return chrono::nanoseconds(0);
+        }
+
+        const uint64_t rank = clamp<uint64_t>(static_cast<uint64_t>(ceil(quantile * count_)), 1, count_);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            seen += counts_[i];
+            if (seen >= rank) {
+                return chrono::nanoseconds(std::min(GetBucketUpperBound(i), max_));
+            }
+        }
+        return GetMax();
+    }
+
+    LatencyStats::LatencyStats() = default;
+
+    LatencyStats::~LatencyStats() = default;
+
+    LatencyStats::TypeStats& LatencyStats::GetTypeStats(string_view type) {
+        auto stats = find_if(types_.begin(), types_.end(), [type](const TypeStats& stats) { return stats.type == type; });
+        if (stats == types_.end()) {
+            stats = types_.insert(types_.end(), TypeStats{ string(type), {}, {} });
+        }
+        return *stats;
+    }
+
+    void LatencyStats::Record(string_view type, chrono::nanoseconds execution, chrono::nanoseconds serialization) {
+        TypeStats& stats = GetTypeStats(type);
+        stats.execution.Record(execution);
+        stats.serialization.Record(serialization);
+    }
+
+    void LatencyStats::Merge(const LatencyStats& other) {
+        for (const TypeStats& other_stats : other.types_) {
+            TypeStats& stats = GetTypeStats(other_stats.type);
+            stats.execution.Merge(other_stats.execution);
+            stats.serialization.Merge(other_stats.serialization);
+        }
+    }
+
+    void LatencyStats::Print(ostream& out) const {
+        {
+            ::json::Writer writer(out, ::json::Writer::Format::COMPACT);
+            const auto write_histogram = [&writer](const LatencyHistogram& histogram) {
+                writer.StartDict().Key("p50"sv);
+                WriteNumber(writer, histogram.GetPercentile(0.5).count());
+                writer.Key("p90"sv);
+                WriteNumber(writer, histogram.GetPercentile(0.9).count());
+                writer.Key("p99"sv);
+                WriteNumber(writer, histogram.GetPercentile(0.99).count());
+                writer.Key("max"sv);
+                WriteNumber(writer, histogram.GetMax().count());
+                writer.EndDict();
+            };
+
+            //Тип запроса пришёл из входа и экранируется как ключ
+            writer.StartDict().Key("latency_ns"sv).StartDict();
+            for (const TypeStats& stats : types_) {
+                writer.Key(stats.type).StartDict().Key("count"sv);
+                WriteNumber(writer, stats.execution.GetCount());
+                writer.Key("execution"sv);
+                write_histogram(stats.execution);
+                writer.Key("serialization"sv);
+                write_histogram(stats.serialization);
+                writer.EndDict();
+            }
+            writer.EndDict().EndDict();
+        }
+        out << '\n';
+    }
+
+    RequestTimer::RequestTimer(LatencyStats* stats, string_view type)
+        : stats_(stats)
+        , type_(type) {
+        if (stats_ != nullptr) {
+            start_ = chrono::steady_clock::now();
+        }
+    }
+
+    void RequestTimer::MarkExecuted() {
+        if (stats_ != nullptr) {
+            executed_ = chrono::steady_clock::now();
+        }
+    }
+
+    void RequestTimer::Finish() {
+        Finish(executed_ - start_);
+    }
+
+    void RequestTimer::Finish(chrono::nanoseconds execution) {
+        if (stats_ != nullptr && executed_ != chrono::steady_clock::time_point()) {
+            stats_->Record(type_, execution, chrono::steady_clock::now() - executed_);
+        }
+    }
+}
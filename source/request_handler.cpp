@@ -3,36 +3,70 @@
 using namespace std;
 
 namespace renderer {
+	namespace {
+		//Сколько ближайших остановок рассматривается для маршрута из произвольной точки
+		const size_t ROUTE_NEAREST_STOPS = 5;
+	}
+
+	BaseView::BaseView(shared_ptr<const BaseState> state, const map_renderer::MapRenderer& renderer)
+		: state_(move(state))
+		, renderer_(renderer)
+	{
+	}
+
 	RequestHandler::RequestHandler(::directory::TransportCatalogue& db, const map_renderer::MapRenderer& renderer, const pair<int, double>& routing_settings)
-		: db_(db)
+		: mutable_db_(&db)
 		, renderer_(renderer)
 		, routing_settings_(routing_settings)
 	{
+		state_.Update([&db](BaseState& state) {
+			state.db = &db;
+		});
+	}
+
+	RequestHandler::RequestHandler(::directory::CatalogueSnapshot snapshot, const map_renderer::MapRenderer& renderer, const pair<int, double>& routing_settings)
+		: renderer_(renderer)
+		, routing_settings_(routing_settings)
+	{
+		state_.Update([&snapshot](BaseState& state) {
+			state.snapshot = move(snapshot);
+			state.db = state.snapshot.get();
+		});
+	}
+
+	BaseView RequestHandler::GetView() const {
+		return BaseView(state_.Get(), renderer_);
 	}
 
 	void RequestHandler::RestoreGraph(std::vector <::graph::Edge<double>>& edges, ::graph::VertexId& vertex_count, ::graph::VertexId& current_id,
 		std::deque<transport_router::TransportRouter::Ids>& id_s_, std::map<::graph::EdgeId, transport_router::TransportRouter::EdgeInfo>& edges_id_) {
-		tr_rout_ = std::make_optional<::transport_router::TransportRouter>(vertex_count);
-		router_.emplace(tr_rout_.value().Restore(edges, current_id, id_s_, edges_id_));
+		auto routing = make_shared<RoutingState>(RoutingState{ ::transport_router::TransportRouter(vertex_count), nullopt });
+		routing->router.emplace(routing->tr_rout.Restore(edges, current_id, id_s_, edges_id_));
+		state_.Update([&routing](BaseState& state) {
+			state.routing = move(routing);
+		});
 	}
 
 	void RequestHandler::SetRouterWithNewGraph() {
-		tr_rout_ = std::make_optional<::transport_router::TransportRouter>(db_.GetCountStops() * 2);
-		router_.emplace(tr_rout_.value().CreateGraph(db_, routing_settings_));
+		state_.Update([this](BaseState& state) {
+			auto routing = make_shared<RoutingState>(RoutingState{ ::transport_router::TransportRouter(state.db->GetCountStops() * 2), nullopt });
+			routing->router.emplace(routing->tr_rout.CreateGraph(*state.db, routing_settings_));
+			state.routing = move(routing);
+		});
 	}
 
-	::directory::Bus* RequestHandler::GetInfoAboutRoute(const string_view& bus_name) {
-		return db_.GetInfoAboutRoute(bus_name);
+	const ::directory::Bus* BaseView::GetInfoAboutRoute(const string_view& bus_name) const {
+		return state_->db->GetInfoAboutRoute(bus_name);
 	}
 
-	tuple<bool, set<string_view>> RequestHandler::GetBusesForStop(const string_view& stop_name) {
-		return db_.GetBusesForStop(stop_name);
+	tuple<bool, set<string_view>> BaseView::GetBusesForStop(const string_view& stop_name) const {
+		return state_->db->GetBusesForStop(stop_name);
 	}
 
-	svg::Document RequestHandler::RenderMap() const {
+	svg::Document BaseView::RenderMap() const {
 		svg::Document result;
 
-		unordered_map<string_view, ::geo::Coordinates> stops_with_coordinates = db_.GetStopsWithCoordinates();
+		unordered_map<string_view, ::geo::Coordinates> stops_with_coordinates = state_->db->GetStopsWithCoordinates();
 		deque<::geo::Coordinates> coordinates;
 		for (const auto& [stop, coordinate]: stops_with_coordinates) {
 			coordinates.push_back(coordinate);
@@ -41,12 +75,12 @@ namespace renderer {
 		//Все остановки со всех маршрутов
 		set<string> all_stops;
 
-		vector<::directory::Bus*> buses = db_.GetBuses();
+		vector<const ::directory::Bus*> buses = state_->db->GetBuses();
 
-		deque<pair<::directory::Bus*, vector<string_view>>> buses_with_stops;
+		deque<pair<const ::directory::Bus*, vector<string_view>>> buses_with_stops;
 		
 		for (const auto& bus : buses) {
-			vector<string_view> stops = db_.GetStopsForBus(bus->bus_name);
+			vector<string_view> stops = state_->db->GetStopsForBus(bus->bus_name);
 
 			if (stops.size() > 0) {
 				all_stops.insert(stops.begin(), stops.end());
@@ -71,30 +105,286 @@ namespace renderer {
 		return result;
 	}
 
-	::transport_router::TransportRouter::RouteInfo RequestHandler::GetRouteForQuery(const ::directory::json_detail::QueryStat& query) {
-		return tr_rout_.value().GetRoute(router_.value(), query.from, query.to);
+	::transport_router::TransportRouter::RouteInfo BaseView::GetRouteForQuery(const ::directory::json_detail::QueryStat& query) const {
+		const RoutingState& routing = *state_->routing;
+		if (query.from_point || query.to_point) {
+			return routing.tr_rout.GetRoute(GetRouteEnds(query.from, query.from_point), GetRouteEnds(query.to, query.to_point));
+		}
+		if (!routing.router) {
+			//граф менялся после построения Router
+			return routing.tr_rout.GetRoute(GetRouteEnds(query.from, nullopt), GetRouteEnds(query.to, nullopt));
+		}
+		return routing.tr_rout.GetRoute(routing.router.value(), query.from, query.to);
+	}
+
+	vector<::transport_router::TransportRouter::RouteInfo> BaseView::GetRoutesForQueries(const vector<const ::directory::json_detail::QueryStat*>& queries) const {
+		const RoutingState& routing = *state_->routing;
+		vector<::transport_router::TransportRouter::RouteInfo> result(queries.size());
+
+		//Между остановками Router отвечает без поиска
+		vector<size_t> searched;
+		vector<::transport_router::TransportRouter::StopsWithWalkTime> to;
+		for (size_t i = 0; i < queries.size(); ++i) {
+			if (routing.router && !queries[i]->from_point && !queries[i]->to_point) {
+				result[i] = GetRouteForQuery(*queries[i]);
+			}
+			else {
+				searched.push_back(i);
+				to.push_back(GetRouteEnds(queries[i]->to, queries[i]->to_point));
+			}
+		}
+
+		if (!searched.empty()) {
+			const ::directory::json_detail::QueryStat& query = *queries[searched.front()];
+			auto routes = routing.tr_rout.GetRoutes(GetRouteEnds(query.from, query.from_point), to);
+			for (size_t i = 0; i < searched.size(); ++i) {
+				result[searched[i]] = std::move(routes[i]);
+			}
+		}
+		return result;
+	}
+
+	vector<pair<string_view, set<string_view>>> BaseView::GetStopsByPrefix(const ::directory::json_detail::QueryStat& query) const {
+		vector<pair<string_view, set<string_view>>> result;
+		for (size_t stop_id : state_->stop_search->FindByPrefix(query.prefix, query.count)) {
+			const string_view stop_name = state_->db->GetStopName(stop_id);
+			result.emplace_back(stop_name, std::get<1>(state_->db->GetBusesForStop(stop_name)));
+		}
+		return result;
+	}
+
+	::transport_router::TransportRouter::StopsWithWalkTime BaseView::GetRouteEnds(const string& stop, const optional<::geo::Coordinates>& point) const {
+		if (!point) {
+			return { { stop, 0.0 } };
+		}
+
+		::transport_router::TransportRouter::StopsWithWalkTime result;
+		for (const auto& item : state_->spatial_index->FindNearest(*point, ROUTE_NEAREST_STOPS, 0, state_->unserved_stops)) {
+			//Метры переводим в км и часы в минуты
+			result.emplace_back(state_->db->GetStopName(item.stop_id), (item.distance / 1000.0) * 60 / state_->walk_velocity);
+		}
+		return result;
+	}
+
+	vector<pair<string_view, double>> BaseView::GetNearestStops(const ::directory::json_detail::QueryStat& query) const {
+		vector<pair<string_view, double>> result;
+		for (const auto& item : state_->spatial_index->FindNearest(query.coordinates, query.count, query.radius)) {
+			result.emplace_back(state_->db->GetStopName(item.stop_id), item.distance);
+		}
+		return result;
+	}
+
+	void RequestHandler::GetVariableForGraph(std::vector <::graph::Edge<double>>& edges, ::graph::VertexId& vertex_count) const {
+		const auto state = state_.Get();
+		vertex_count = state->routing->tr_rout.GetGraph().GetVertexCount();
+		edges = state->routing->tr_rout.GetGraph().GetEdges();
+	}
+
+	void RequestHandler::GetVariableTransportRouter(::graph::VertexId& current_id, std::deque<transport_router::TransportRouter::Ids>& id_s_, std::map<::graph::EdgeId, transport_router::TransportRouter::EdgeInfo>& edges_id_) const {
+		state_.Get()->routing->tr_rout.GetVariable(current_id, id_s_, edges_id_);
+	}
+
+	::directory::TransportCatalogue& RequestHandler::GetMutableCatalogue() {
+		if (mutable_db_ == nullptr) {
+			throw logic_error("Catalogue snapshot is read-only");
+		}
+		return *mutable_db_;
+	}
+
+	void RequestHandler::AddStop(string_view name, ::geo::Coordinates coordinates) {
+		GetMutableCatalogue().AddStation(name, coordinates);
+	}
+
+	void RequestHandler::AddDistance(string_view from, string_view to, uint64_t distance) {
+		GetMutableCatalogue().SetDistanceBetweenStops(from, to, distance);
+	}
+
+	void RequestHandler::AddBus(string_view name, const vector<string_view>& stops, bool is_roundtrip) {
+		GetMutableCatalogue().AddRoute(name, stops, is_roundtrip);
+	}
+
+	void RequestHandler::SetWalkVelocity(double walk_velocity) {
+		state_.Update([walk_velocity](BaseState& state) {
+			state.walk_velocity = walk_velocity;
+		});
+	}
+
+	void RequestHandler::ApplyUpdates(const vector<::directory::json_detail::QueryUpdate>& queries) {
+		if (queries.empty()) {
+			return;
+		}
+
+		state_.Update([this, &queries](BaseState& state) {
+			::directory::TransportCatalogue db(*state.db);
+			bool is_stops_changed = false;
+			set<string> changed_buses;
+
+			//Порядок как при создании базы: остановки, дистанции, автобусы. Остановки удаляются последними,
+			//чтобы вместе с остановкой можно было удалить проходящие через неё автобусы
+			for (const auto& query : queries) {
+				if (query.type == "Stop"s && !query.is_remove && query.has_coordinates) {
+					db.UpdateStation(query.stop.stop, query.stop.coordinates);
+					is_stops_changed = true;
+				}
+			}
+
+			auto update_distance = [&db, &changed_buses](string_view from, string_view to, optional<uint64_t> distance) {
+				if (distance) {
+					db.UpdateDistance(from, to, *distance);
+				}
+				else {
+					db.RemoveDistance(from, to);
+				}
+				const auto [is_found, buses] = db.GetBusesForStop(from);
+				changed_buses.insert(buses.begin(), buses.end());
+			};
+
+			for (const auto& query : queries) {
+				if (query.type == "Stop"s && !query.is_remove) {
+					for (const auto& [to, distance] : query.stop.distance_to_stop) {
+						update_distance(query.stop.stop, to, distance);
+					}
+				}
+				else if (query.type == "Distance"s) {
+					update_distance(query.from, query.to, query.is_remove ? nullopt : optional<uint64_t>(query.distance));
+				}
+			}
+
+			for (const auto& query : queries) {
+				if (query.type != "Bus"s) {
+					continue;
+				}
+				if (query.is_remove) {
+					db.RemoveRoute(query.bus.bus);
+				}
+				else {
+					db.UpdateRoute(query.bus.bus, { query.bus.stops.begin(), query.bus.stops.end() }, query.bus.is_roundtrip);
+				}
+				changed_buses.insert(query.bus.bus);
+			}
+
+			for (const auto& query : queries) {
+				if (query.type == "Stop"s && query.is_remove) {
+					db.RemoveStation(query.stop.stop);
+					is_stops_changed = true;
+				}
+			}
+
+			state.snapshot = ::directory::MakeSnapshot(move(db));
+			state.db = state.snapshot.get();
+
+			//Рёбра меняются в копии графа: опубликованный граф и построенный по нему Router остаются целыми
+			if (state.routing && !changed_buses.empty()) {
+				auto routing = make_shared<RoutingState>(RoutingState{ state.routing->tr_rout, nullopt });
+				for (const string& bus : changed_buses) {
+					routing->tr_rout.UpdateBusEdges(*state.db, routing_settings_, bus);
+				}
+				state.routing = move(routing);
+			}
+
+			if (state.incidence_index && (is_stops_changed || !changed_buses.empty())) {
+				state.incidence_index = make_shared<const ::incidence_index::IncidenceIndex>(state.db->GetAllStopBusIds());
+			}
+
+			if (is_stops_changed) {
+				const vector<bool> removed = state.db->GetRemovedStops();
+				if (state.spatial_index) {
+					state.spatial_index = make_shared<const ::spatial_index::SpatialIndex>(state.db->GetAllStopCoordinates(), removed);
+				}
+				if (state.stop_search) {
+					state.stop_search = make_shared<const ::stop_search::StopNameIndex>(state.db->GetAllStopNames(), removed);
+				}
+			}
+
+			if (state.spatial_index && (is_stops_changed || !changed_buses.empty())) {
+				state.unserved_stops = GetUnservedStops(*state.db);
+			}
+		});
+		mutable_db_ = nullptr;
+	}
+
+	void RequestHandler::SetSpatialIndex() {
+		state_.Update([](BaseState& state) {
+			state.spatial_index = make_shared<const ::spatial_index::SpatialIndex>(state.db->GetAllStopCoordinates());
+			state.unserved_stops = GetUnservedStops(*state.db);
+		});
+	}
+
+	void RequestHandler::RestoreSpatialIndex(::spatial_index::Grid& grid) {
+		state_.Update([&grid](BaseState& state) {
+			state.spatial_index = make_shared<const ::spatial_index::SpatialIndex>(std::move(grid), state.db->GetAllStopCoordinates());
+			state.unserved_stops = GetUnservedStops(*state.db);
+		});
 	}
 
-	void RequestHandler::GetVariableForGraph(std::vector <::graph::Edge<double>>& edges, ::graph::VertexId& vertex_count) {
-		vertex_count = tr_rout_.value().GetGraph().GetVertexCount();
-		edges = std::move(tr_rout_.value().GetGraph().GetEdges());
+	vector<bool> RequestHandler::GetUnservedStops(const ::directory::TransportCatalogue& db) {
+		const vector<vector<uint32_t>> stop_bus_ids = db.GetAllStopBusIds();
+		vector<bool> result(stop_bus_ids.size(), false);
+		for (size_t stop_id = 0; stop_id < stop_bus_ids.size(); ++stop_id) {
+			result[stop_id] = stop_bus_ids[stop_id].empty();
+		}
+		return result;
 	}
 
-	void RequestHandler::GetVariableTransportRouter(::graph::VertexId& current_id, std::deque<transport_router::TransportRouter::Ids>& id_s_, std::map<::graph::EdgeId, transport_router::TransportRouter::EdgeInfo>& edges_id_) {
-		tr_rout_.value().GetVariable(current_id, id_s_, edges_id_);
+	void RequestHandler::GetVariableSpatialIndex(::spatial_index::Grid& grid) const {
+		grid = state_.Get()->spatial_index->GetGrid();
 	}
 
-	void RequestHandler::FillTransportCatalogue(::serialization_space::SerializeVariable& sv) {
-		for (const auto& query : sv.stop_queries) {
-			db_.AddStation(query.stop, query.coordinates);
+	optional<vector<string_view>> BaseView::GetCommonBuses(const ::directory::json_detail::QueryStat& query) const {
+		vector<size_t> stop_ids;
+		for (const string& stop : query.names) {
+			const optional<size_t> stop_id = state_->db->FindStopId(stop);
+			if (!stop_id) {
+				return nullopt;
+			}
+			stop_ids.push_back(*stop_id);
+		}
+
+		vector<string_view> result;
+		for (uint32_t bus_id : state_->incidence_index->GetCommonBuses(stop_ids)) {
+			result.push_back(state_->db->GetBusName(bus_id));
 		}
+		sort(result.begin(), result.end());
+		return result;
+	}
 
-		for (auto& query : sv.stop_queries) {
-			db_.AddStationDistance(query.stop, query.distance_to_stop);
+	optional<vector<string_view>> BaseView::GetCommonStops(const ::directory::json_detail::QueryStat& query) const {
+		vector<size_t> bus_ids;
+		for (const string& bus : query.names) {
+			const optional<size_t> bus_id = state_->db->FindBusId(bus);
+			if (!bus_id) {
+				return nullopt;
+			}
+			bus_ids.push_back(*bus_id);
 		}
 
-		for (auto& query : sv.bus_queries) {
-			db_.AddRoute(query.bus, query.stops, query.is_roundtrip);
+		vector<string_view> result;
+		for (uint32_t stop_id : state_->incidence_index->GetCommonStops(bus_ids)) {
+			result.push_back(state_->db->GetStopName(stop_id));
 		}
+		sort(result.begin(), result.end());
+		return result;
+	}
+
+	void RequestHandler::SetIncidenceIndex() {
+		state_.Update([](BaseState& state) {
+			state.incidence_index = make_shared<const ::incidence_index::IncidenceIndex>(state.db->GetAllStopBusIds());
+		});
+	}
+
+	void RequestHandler::SetStopSearch() {
+		state_.Update([](BaseState& state) {
+			state.stop_search = make_shared<const ::stop_search::StopNameIndex>(state.db->GetAllStopNames());
+		});
+	}
+
+	void RequestHandler::RestoreStopSearch(::stop_search::NameIndexData& name_index) {
+		state_.Update([&name_index](BaseState& state) {
+			state.stop_search = make_shared<const ::stop_search::StopNameIndex>(std::move(name_index));
+		});
+	}
+
+	void RequestHandler::GetVariableStopSearch(::stop_search::NameIndexData& name_index) const {
+		name_index = state_.Get()->stop_search->GetData();
 	}
 }
\ No newline at end of file
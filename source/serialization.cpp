@@ -2,6 +2,7 @@
 #include "svg.h"
 
 #include <fstream>
+#include <stdexcept>
 #include <variant>
 
 namespace serialization_space {
@@ -11,55 +12,65 @@ namespace serialization_space {
 		:sv_(sv)
 		, path_(path) {}
 
-	void Serialization::Serialize() {
+	void Serialization::Serialize(const ::directory::TransportCatalogue& catalogue) {
 		if (tr_proto_.has_value()) {
 			tr_proto_.reset();
 		}
 		tr_proto_ = std::make_optional<::transport_catalogue_serialize::TransportCatalogue>();
 
 		SerializeTransportRouter();
-		SerializeStopQueries();
-		SerializeBusQueries();
+		SerializeCatalogue(catalogue);
 		SerializeRoutingSettings();
 		SerializeGraph();
 		SerializeMapRenderer();
+		SerializeSpatialIndex();
+		SerializeStopSearch();
 
 		std::ofstream out_file(path_, std::ios::binary);
 		tr_proto_.value().SerializeToOstream(&out_file);
 	}
 
-	void Serialization::SerializeStopQueries() {
-		for (const ::directory::json_detail::QueryStop& stop : sv_.stop_queries) {
-			::transport_catalogue_serialize::Stop new_stop;
+	void Serialization::SerializeCatalogue(const ::directory::TransportCatalogue& catalogue) {
+		auto& stops = *tr_proto_.value().mutable_stops();
+		auto& buses = *tr_proto_.value().mutable_buses();
 
-			new_stop.set_name(stop.stop);
+		std::vector<std::vector<uint32_t>> stop_bus_ids = catalogue.GetAllStopBusIds();
+		for (const ::directory::Stop& stop : catalogue.GetAllStops()) {
+			::transport_catalogue_serialize::Stop& new_stop = *stops.Add();
+
+			new_stop.set_name(std::string(stop.station_name));
 			new_stop.set_latitude(stop.coordinates.lat);
 			new_stop.set_longitude(stop.coordinates.lng);
+			new_stop.mutable_buses()->Add(stop_bus_ids.at(stop.id).begin(), stop_bus_ids.at(stop.id).end());
+		}
 
-			for (const auto& [name, distance] : stop.distance_to_stop) {
-				(*new_stop.mutable_road_distances())[name] = static_cast<int32_t>(distance);
-			}
-
-			tr_proto_.value().mutable_stops()->Add(std::move(new_stop));
+		for (const auto& [from, to, distance] : catalogue.GetAllDistances()) {
+			::transport_catalogue_serialize::RoadDistance& road_distance = *stops.Mutable(from)->add_road_distances();
+			road_distance.set_to(to);
+			road_distance.set_distance(distance);
 		}
-	}
 
-	void Serialization::SerializeBusQueries() {
-		for (const ::directory::json_detail::QueryBus& bus : sv_.bus_queries) {
-			::transport_catalogue_serialize::Bus new_bus;
+		std::vector<::directory::BusStat> stats = catalogue.GetAllBusStats();
+		size_t bus_id = 0;
+		for (const ::directory::Bus& bus : catalogue.GetAllBuses()) {
+			::transport_catalogue_serialize::Bus& new_bus = *buses.Add();
 
 			new_bus.set_is_roundtrip(bus.is_roundtrip);
-			new_bus.set_name(bus.bus);
+			new_bus.set_name(std::string(bus.bus_name));
 
-			for (const int32_t& id : bus_edge_ids_.at(bus.bus)) {
+			for (const int32_t& id : bus_edge_ids_[bus.bus_name]) {
 				new_bus.add_ids(id);
 			}
 
-			for (const std::string& stop : bus.stops) {
-				new_bus.add_stops(stop);
-			}
+			std::vector<uint32_t> stop_ids = catalogue.GetStopIdsForBus(bus);
+			new_bus.mutable_stop_ids()->Add(stop_ids.begin(), stop_ids.end());
 
-			tr_proto_.value().mutable_buses()->Add(std::move(new_bus));
+			const ::directory::BusStat& stat = stats.at(bus_id++);
+			::transport_catalogue_serialize::BusStat& stat_s = *new_bus.mutable_stat();
+			stat_s.set_stops_on_route(stat.stops_on_route);
+			stat_s.set_unique_stops(stat.unique_stops);
+			stat_s.set_route_length(stat.route_length);
+			stat_s.set_curvature(stat.curvature);
 		}
 	}
 
@@ -67,6 +78,7 @@ namespace serialization_space {
 		::graph_proto::RoutingSettings routing_s;
 		routing_s.set_bus_wait_time(sv_.routing_settings.first);
 		routing_s.set_bus_velocity(sv_.routing_settings.second);
+		routing_s.set_walk_velocity(sv_.walk_velocity);
 		*tr_proto_.value().mutable_rout_s() = std::move(routing_s);
 	}
 
@@ -118,7 +130,7 @@ namespace serialization_space {
 		for (const auto& elem : sv_.id_s_) {
 			::transport_router_serialize::Ids ids;
 			ids.set_id(static_cast<int32_t>(elem.id));
-			ids.set_name(elem.name);
+			ids.set_name(std::string(elem.name));
 			ids.set_is_transfer(elem.is_transfer);
 			transport_router.mutable_ids()->Add(std::move(ids));
 		}
@@ -131,7 +143,7 @@ namespace serialization_space {
 			new_edge_info.set_span_count(edge_info.span_count);
 			new_edge_info.set_time(edge_info.time);
 			new_edge_info.set_is_bus_type(edge_info.is_bus_type);
-			new_edge_info.set_stop_name(edge_info.stop_name);
+			new_edge_info.set_stop_name(std::string(edge_info.stop_name));
 
 			if (edge_info.bus.size() > 0) {
 				bus_edge_ids_[edge_info.bus].insert(static_cast<int32_t>(id));
@@ -143,6 +155,31 @@ namespace serialization_space {
 		*tr_proto_.value().mutable_tr() = std::move(transport_router);
 	}
 
+	void Serialization::SerializeSpatialIndex() {
+		::spatial_index_proto::Grid grid_s;
+
+		grid_s.set_min_lat(sv_.grid.min_lat);
+		grid_s.set_min_lng(sv_.grid.min_lng);
+		grid_s.set_cell_lat(sv_.grid.cell_lat);
+		grid_s.set_cell_lng(sv_.grid.cell_lng);
+		grid_s.set_rows(sv_.grid.rows);
+		grid_s.set_cols(sv_.grid.cols);
+		grid_s.mutable_cell_offsets()->Add(sv_.grid.cell_offsets.begin(), sv_.grid.cell_offsets.end());
+		grid_s.mutable_stop_ids()->Add(sv_.grid.stop_ids.begin(), sv_.grid.stop_ids.end());
+
+		*tr_proto_.value().mutable_grid() = std::move(grid_s);
+	}
+
+	void Serialization::SerializeStopSearch() {
+		::stop_search_proto::NameIndex name_index_s;
+
+		name_index_s.set_keys(sv_.name_index.keys);
+		name_index_s.mutable_offsets()->Add(sv_.name_index.offsets.begin(), sv_.name_index.offsets.end());
+		name_index_s.mutable_stop_ids()->Add(sv_.name_index.stop_ids.begin(), sv_.name_index.stop_ids.end());
+
+		*tr_proto_.value().mutable_name_index() = std::move(name_index_s);
+	}
+
 	::svg_proto::Color Serialization::GetColorProto(const ::svg::Color& color) {
 		::svg_proto::Color color_proto;
 		if (std::holds_alternative<std::string>(color)) {
@@ -173,60 +210,77 @@ namespace serialization_space {
 		return color_proto;
 	}
 
-	void Serialization::Deserialize() {
+	void Serialization::Deserialize(::directory::TransportCatalogue& catalogue) {
 		if (tr_proto_.has_value()) {
 			tr_proto_.reset();
 		}
 		tr_proto_ = std::make_optional<::transport_catalogue_serialize::TransportCatalogue>();
 
 		std::ifstream in_file(path_, std::ios::binary);
-
-		if (tr_proto_.value().ParseFromIstream(&in_file)) {
-			DeserializeBusQueries();
-			DeserializeStopQueries();
-			DeserializeRoutingSettings();
-			DeserializeGraph();
-			DeserializeMapRenderer();
-			DeserializeTransportRouter();
+		if (!in_file) {
+			throw std::runtime_error("Can't open base file '"s + path_ + "'"s);
+		}
+		if (!tr_proto_.value().ParseFromIstream(&in_file)) {
+			throw std::runtime_error("Can't parse base file '"s + path_ + "'"s);
 		}
+
+		DeserializeCatalogue(catalogue);
+		DeserializeRoutingSettings();
+		DeserializeGraph();
+		DeserializeMapRenderer();
+		DeserializeTransportRouter(catalogue);
+		DeserializeSpatialIndex();
+		DeserializeStopSearch();
+
+		//Всё нужное уже перенесено, буфер protobuf больше не держим
+		edge_bus_names_.clear();
+		tr_proto_.reset();
 	}
 
-	void Serialization::DeserializeStopQueries() {
-		for (const auto& stop : *tr_proto_.value().mutable_stops()) {
-			::directory::json_detail::QueryStop new_stop;
-			new_stop.stop = stop.name();
-			new_stop.coordinates = { stop.latitude(), stop.longitude() };
-			for (const auto& [name, distance] : stop.road_distances()) {
-				new_stop.distance_to_stop[name] = distance;
-			}
-			sv_.stop_queries.emplace_back(std::move(new_stop));
+	void Serialization::DeserializeCatalogue(::directory::TransportCatalogue& catalogue) {
+		const auto& stops = tr_proto_.value().stops();
+		const auto& buses = tr_proto_.value().buses();
+
+		for (const auto& stop : stops) {
+			catalogue.AddStation(stop.name(), { stop.latitude(), stop.longitude() });
 		}
-	}
 
-	void Serialization::DeserializeBusQueries() {
-		for (const auto& bus : *tr_proto_.value().mutable_buses()) {
-			::directory::json_detail::QueryBus new_bus;
-			new_bus.bus = bus.name();
-			new_bus.is_roundtrip = bus.is_roundtrip();
-			for (const auto& stop : bus.stops()) {
-				new_bus.stops.push_back(stop);
+		for (int from = 0; from < stops.size(); ++from) {
+			for (const auto& road_distance : stops.Get(from).road_distances()) {
+				catalogue.RestoreDistance(from, road_distance.to(), road_distance.distance());
 			}
+		}
+
+		std::vector<uint32_t> stop_ids;
+		for (const auto& bus : buses) {
+			stop_ids.assign(bus.stop_ids().begin(), bus.stop_ids().end());
+
+			const ::transport_catalogue_serialize::BusStat& stat = bus.stat();
+			catalogue.RestoreRoute(bus.name(), stop_ids, bus.is_roundtrip(),
+				{ stat.stops_on_route(), stat.unique_stops(), stat.route_length(), stat.curvature() });
 
 			for (const auto& id : bus.ids()) {
-				bus_edge_ids_[bus.name()].insert(id);
+				edge_bus_names_[id] = catalogue.GetAllBuses().back().bus_name;
 			}
-			
-			sv_.bus_queries.emplace_back(std::move(new_bus));
+		}
+
+		std::vector<uint32_t> bus_ids;
+		for (int stop_id = 0; stop_id < stops.size(); ++stop_id) {
+			bus_ids.assign(stops.Get(stop_id).buses().begin(), stops.Get(stop_id).buses().end());
+			catalogue.RestoreBusesForStop(stop_id, bus_ids);
 		}
 	}
 
 	void Serialization::DeserializeRoutingSettings() {
-		::graph_proto::RoutingSettings routing_s = tr_proto_.value().rout_s();
+		const ::graph_proto::RoutingSettings& routing_s = tr_proto_.value().rout_s();
 		sv_.routing_settings = std::make_pair(routing_s.bus_wait_time(), routing_s.bus_velocity());
+		if (routing_s.walk_velocity() > 0) {
+			sv_.walk_velocity = routing_s.walk_velocity();
+		}
 	}
 
 	void Serialization::DeserializeMapRenderer() {
-		::map_renderer_proto::RenderSettings render_s = tr_proto_.value().rend_s();
+		const ::map_renderer_proto::RenderSettings& render_s = tr_proto_.value().rend_s();
 		sv_.renderer.width = render_s.width();
 		sv_.renderer.height = render_s.height();
 		sv_.renderer.padding = render_s.padding();
@@ -241,15 +295,16 @@ namespace serialization_space {
 		sv_.renderer.underlayer_width = render_s.underlayer_width();
 		sv_.renderer.underlayer_color = GetColorSvg(render_s.underlayer_color());
 
-		for (::svg_proto::Color color : render_s.color_palette()) {
+		for (const ::svg_proto::Color& color : render_s.color_palette()) {
 			sv_.renderer.color_palette.push_back(GetColorSvg(color));
 		}
 	}
 
 	void Serialization::DeserializeGraph() {
-		::graph_proto::Edges edges_s = tr_proto_.value().edges();
+		const ::graph_proto::Edges& edges_s = tr_proto_.value().edges();
 
 		sv_.vertex_count = edges_s.vertex_count();
+		sv_.edges.reserve(edges_s.edges_size());
 
 		for (const ::graph_proto::Edge& edge : edges_s.edges()) {
 			::graph::Edge<double> e;
@@ -260,9 +315,9 @@ namespace serialization_space {
 		}
 	}
 
-	void Serialization::DeserializeTransportRouter() {
+	void Serialization::DeserializeTransportRouter(const ::directory::TransportCatalogue& catalogue) {
 		
-		::transport_router_serialize::TransportRouter transport_router = tr_proto_.value().tr();
+		const ::transport_router_serialize::TransportRouter& transport_router = tr_proto_.value().tr();
 
 		sv_.current_id = transport_router.current_id();
 
@@ -270,7 +325,7 @@ namespace serialization_space {
 			::transport_router::TransportRouter::Ids new_id;
 			new_id.id = id.id();
 			new_id.is_transfer = id.is_transfer();
-			new_id.name = id.name();
+			new_id.name = catalogue.FindStopName(id.name());
 			sv_.id_s_.emplace_back(std::move(new_id));
 		}
 
@@ -280,24 +335,38 @@ namespace serialization_space {
 
 			new_edge_info.id_from = edge_info.id_from();
 			new_edge_info.id_to = edge_info.id_to();
-			new_edge_info.bus = FindBusName(id);
+			if (auto it = edge_bus_names_.find(id); it != edge_bus_names_.end()) {
+				new_edge_info.bus = it->second;
+			}
 			new_edge_info.span_count = edge_info.span_count();
 			new_edge_info.time = edge_info.time();
 			new_edge_info.is_bus_type = edge_info.is_bus_type();
-			new_edge_info.stop_name = edge_info.stop_name();
+			new_edge_info.stop_name = catalogue.FindStopName(edge_info.stop_name());
 
 			sv_.edges_id_.emplace(id, std::move(new_edge_info));
 		}
 		
 	}
 
-	std::string Serialization::FindBusName(int32_t id) {
-		for (const auto& [name, ids] : bus_edge_ids_) {
-			if (ids.find(id) != ids.end()) {
-				return name;
-			}
-		}
-		return ""s;
+	void Serialization::DeserializeSpatialIndex() {
+		const ::spatial_index_proto::Grid& grid_s = tr_proto_.value().grid();
+
+		sv_.grid.min_lat = grid_s.min_lat();
+		sv_.grid.min_lng = grid_s.min_lng();
+		sv_.grid.cell_lat = grid_s.cell_lat();
+		sv_.grid.cell_lng = grid_s.cell_lng();
+		sv_.grid.rows = grid_s.rows();
+		sv_.grid.cols = grid_s.cols();
+		sv_.grid.cell_offsets.assign(grid_s.cell_offsets().begin(), grid_s.cell_offsets().end());
+		sv_.grid.stop_ids.assign(grid_s.stop_ids().begin(), grid_s.stop_ids().end());
+	}
+
+	void Serialization::DeserializeStopSearch() {
+		const ::stop_search_proto::NameIndex& name_index_s = tr_proto_.value().name_index();
+
+		sv_.name_index.keys = name_index_s.keys();
+		sv_.name_index.offsets.assign(name_index_s.offsets().begin(), name_index_s.offsets().end());
+		sv_.name_index.stop_ids.assign(name_index_s.stop_ids().begin(), name_index_s.stop_ids().end());
 	}
 
 	::svg::Color Serialization::GetColorSvg(::svg_proto::Color color) {
@@ -0,0 +1,219 @@
+#define _USE_MATH_DEFINES
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+namespace spatial_index {
+
+    using namespace std;
+
+    namespace {
+        //Длина одного градуса меридиана в метрах
+        const double METERS_PER_DEGREE = 6371000 * M_PI / 180.0;
+
+        //Желаемое среднее число остановок в ячейке
+        const double STOPS_PER_CELL = 2.0;
+
+        //Запас на отличие расстояния по сфере от расстояния на плоской сетке
+        const double BOUND_FACTOR = 0.9;
+    }
+
+    SpatialIndex::SpatialIndex(const vector<::geo::Coordinates>& points, const vector<bool>& excluded) {
+        grid_.cell_offsets.assign(1, 0);
+
+        vector<uint32_t> included;
+        included.reserve(points.size());
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (i >= excluded.size() || !excluded[i]) {
+                included.push_back(static_cast<uint32_t>(i));
+            }
+        }
+        if (included.empty()) {
+            return;
+        }
+
+        const auto [bottom_it, top_it] = minmax_element(included.begin(), included.end(), [&points](auto lhs, auto rhs) {
+            return points[lhs].lat < points[rhs].lat; });
+        const auto [left_it, right_it] = minmax_element(included.begin(), included.end(), [&points](auto lhs, auto rhs) {
+            return points[lhs].lng < points[rhs].lng; });
+        const ::geo::Coordinates& bottom = points[*bottom_it];
+        const ::geo::Coordinates& top = points[*top_it];
+        const ::geo::Coordinates& left = points[*left_it];
+        const ::geo::Coordinates& right = points[*right_it];
+
+        grid_.min_lat = bottom.lat;
+        grid_.min_lng = left.lng;
+        const double span_lat = top.lat - bottom.lat;
+        const double span_lng = right.lng - left.lng;
+
+        //Размеры области в метрах, чтобы ячейки были близки к квадратным
+        const double height = span_lat * METERS_PER_DEGREE;
+        const double width = span_lng * METERS_PER_DEGREE * cos((bottom.lat + top.lat) / 2 * M_PI / 180.0);
+        const double target_cells = max(1.0, included.size() / STOPS_PER_CELL);
+
+        double cell_size = 0;
+        if (height > 0 && width > 0) {
+            cell_size = sqrt(height * width / target_cells);
+        }
+        else {
+            cell_size = max(height, width) / target_cells;
+        }
+
+        if (cell_size > 0) {
+            const double max_side = 4 * target_cells;
+            grid_.rows = static_cast<uint32_t>(clamp(ceil(height / cell_size), 1.0, max_side));
+            grid_.cols = static_cast<uint32_t>(clamp(ceil(width / cell_size), 1.0, max_side));
+        }
+        else {
+            grid_.rows = 1;
+            grid_.cols = 1;
+        }
+
+        grid_.cell_lat = span_lat > 0 ? span_lat / grid_.rows : 1;
+        grid_.cell_lng = span_lng > 0 ? span_lng / grid_.cols : 1;
+
+        //Раскладка по ячейкам подсчётом
+        const size_t cell_count = static_cast<size_t>(grid_.rows) * grid_.cols;
+        vector<uint32_t> cell_of_point(included.size());
+        grid_.cell_offsets.assign(cell_count + 1, 0);
+
+        for (size_t i = 0; i < included.size(); ++i) {
+            const ::geo::Coordinates& point = points[included[i]];
+            cell_of_point[i] = GetRow(point.lat) * grid_.cols + GetCol(point.lng);
+            ++grid_.cell_offsets[cell_of_point[i] + 1];
+        }
+
+        for (size_t cell = 0; cell < cell_count; ++cell) {
+            grid_.cell_offsets[cell + 1] += grid_.cell_offsets[cell];
+        }
+
+        grid_.stop_ids.resize(included.size());
+        vector<uint32_t> positions(grid_.cell_offsets.begin(), grid_.cell_offsets.end() - 1);
+        for (size_t i = 0; i < included.size(); ++i) {
+            grid_.stop_ids[positions[cell_of_point[i]]++] = included[i];
+        }
+
+        PreparePoints(points);
+    }
+
+    SpatialIndex::SpatialIndex(Grid grid, const vector<::geo::Coordinates>& points)
+        : grid_(move(grid)) {
+        if (grid_.cell_offsets.empty()) {
+            grid_.cell_offsets.assign(1, 0);
+        }
+        PreparePoints(points);
+    }
+
+    const Grid& SpatialIndex::GetGrid() const {
+        return grid_;
+    }
+
+    void SpatialIndex::PreparePoints(const vector<::geo::Coordinates>& points) {
+        points_.clear();
+        points_.reserve(grid_.stop_ids.size());
+
+        double max_abs_lat = 0;
+        for (uint32_t id : grid_.stop_ids) {
+            points_.push_back(::geo::PrepareCoordinates(points.at(id)));
+            max_abs_lat = max(max_abs_lat, abs(points[id].lat));
+        }
+
+        min_cell_distance_ = min(grid_.cell_lat * METERS_PER_DEGREE,
+            grid_.cell_lng * METERS_PER_DEGREE * cos(max_abs_lat * M_PI / 180.0)) * BOUND_FACTOR;
+    }
+
+    uint32_t SpatialIndex::GetRow(double lat) const {
+        const double row = floor((lat - grid_.min_lat) / grid_.cell_lat);
+        return static_cast<uint32_t>(clamp(row, 0.0, static_cast<double>(grid_.rows - 1)));
+    }
+
+    uint32_t SpatialIndex::GetCol(double lng) const {
+        const double col = floor((lng - grid_.min_lng) / grid_.cell_lng);
+        return static_cast<uint32_t>(clamp(col, 0.0, static_cast<double>(grid_.cols - 1)));
+    }
+
+    vector<SpatialIndex::Item> SpatialIndex::FindNearest(::geo::Coordinates point, size_t count, double radius, const vector<bool>& excluded) const {
+        vector<Item> result;
+        if (points_.empty()) {
+            return result;
+        }
+
+        const auto farther = [](const Item& lhs, const Item& rhs) {
+            return lhs.distance < rhs.distance || (lhs.distance == rhs.distance && lhs.stop_id < rhs.stop_id);
+        };
+
+        //Куча с самым дальним из найденных кандидатов на вершине
+        priority_queue<Item, vector<Item>, decltype(farther)> found(farther);
+
+        const ::geo::PreparedCoordinates prepared_point = ::geo::PrepareCoordinates(point);
+        const long long center_row = GetRow(point.lat);
+        const long long center_col = GetCol(point.lng);
+        const long long max_ring = max(grid_.rows, grid_.cols);
+
+        //Точка запроса может лежать вне сетки, тогда оценка по долготе берётся по её широте
+        const double cell_distance = min(min_cell_distance_,
+            grid_.cell_lng * METERS_PER_DEGREE * cos(min(abs(point.lat), 90.0) * M_PI / 180.0) * BOUND_FACTOR);
+
+        auto scan_cell = [&](long long row, long long col) {
+            if (row < 0 || col < 0 || row >= grid_.rows || col >= grid_.cols) {
+                return;
+            }
+            const size_t cell = static_cast<size_t>(row) * grid_.cols + static_cast<size_t>(col);
+            for (uint32_t i = grid_.cell_offsets[cell]; i < grid_.cell_offsets[cell + 1]; ++i) {
+                const uint32_t stop_id = grid_.stop_ids[i];
+                if (stop_id < excluded.size() && excluded[stop_id]) {
+                    continue;
+                }
+
+                const double distance = ::geo::ComputeDistance(prepared_point, points_[i]);
+                if (radius > 0 && distance > radius) {
+                    continue;
+                }
+
+                const Item item{ stop_id, distance };
+                if (count == 0 || found.size() < count) {
+                    found.push(item);
+                }
+                else if (farther(item, found.top())) {
+                    found.pop();
+                    found.push(item);
+                }
+            }
+        };
+
+        for (long long ring = 0; ring <= max_ring; ++ring) {
+            //Все точки кольца не ближе ring - 1 целых ячеек
+            const double lower_bound = (ring - 1) * cell_distance;
+            if (ring > 0) {
+                if (radius > 0 && lower_bound > radius) {
+                    break;
+                }
+                if (count > 0 && found.size() == count && lower_bound > found.top().distance) {
+                    break;
+                }
+            }
+
+            for (long long col = center_col - ring; col <= center_col + ring; ++col) {
+                scan_cell(center_row - ring, col);
+                if (ring > 0) {
+                    scan_cell(center_row + ring, col);
+                }
+            }
+            for (long long row = center_row - ring + 1; row <= center_row + ring - 1; ++row) {
+                scan_cell(row, center_col - ring);
+                scan_cell(row, center_col + ring);
+            }
+        }
+
+        result.reserve(found.size());
+        while (!found.empty()) {
+            result.push_back(found.top());
+            found.pop();
+        }
+        reverse(result.begin(), result.end());
+
+        return result;
+    }
+}
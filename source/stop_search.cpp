@@ -0,0 +1,178 @@
+#include "stop_search.h"
+
+#include <algorithm>
+
+namespace stop_search {
+
+    using namespace std;
+
+    namespace {
+        //Длина последовательности UTF-8 по первому байту, 0 - если байт не может начинать символ
+        size_t GetSequenceLength(unsigned char lead) {
+            if (lead < 0x80) {
+                return 1;
+            }
+            if ((lead & 0xE0) == 0xC0) {
+                return 2;
+            }
+            if ((lead & 0xF0) == 0xE0) {
+                return 3;
+            }
+            if ((lead & 0xF8) == 0xF0) {
+                return 4;
+            }
+            return 0;
+        }
+
+        void AppendCodePoint(string& out, char32_t code_point) {
+            if (code_point < 0x80) {
+                out.push_back(static_cast<char>(code_point));
+            }
+            else if (code_point < 0x800) {
+                out.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+                out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+            }
+            else if (code_point < 0x10000) {
+                out.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+            }
+            else {
+                out.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+                out.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+            }
+        }
+
+        char32_t FoldCase(char32_t code_point) {
+            if (code_point >= U'A' && code_point <= U'Z') {
+                return code_point + (U'a' - U'A');
+            }
+            //Кириллица: А-Я (U+0410-U+042F) в а-я (U+0430-U+044F), Ё и ё (U+0401, U+0451) в е (U+0435)
+            if (code_point >= 0x0410 && code_point <= 0x042F) {
+                return code_point + 0x20;
+            }
+            if (code_point == 0x0401 || code_point == 0x0451) {
+                return 0x0435;
+            }
+            return code_point;
+        }
+    }
+
+    string NormalizeName(string_view name) {
+        string result;
+        result.reserve(name.size());
+
+        size_t pos = 0;
+        while (pos < name.size()) {
+            const unsigned char lead = static_cast<unsigned char>(name[pos]);
+            const size_t length = GetSequenceLength(lead);
+
+            //Некорректный байт переносим как есть
+            if (length == 0) {
+                result.push_back(name[pos++]);
+                continue;
+            }
+
+            //Символ обрезан - например, при наборе текста
+            if (pos + length > name.size()) {
+                break;
+            }
+
+            char32_t code_point = length == 1 ? lead : lead & (0xFF >> (length + 1));
+            bool is_valid = true;
+            for (size_t i = 1; i < length; ++i) {
+                const unsigned char next = static_cast<unsigned char>(name[pos + i]);
+                if ((next & 0xC0) != 0x80) {
+                    is_valid = false;
+                    break;
+                }
+                code_point = (code_point << 6) | (next & 0x3F);
+            }
+
+            if (!is_valid) {
+                result.push_back(name[pos++]);
+                continue;
+            }
+
+            AppendCodePoint(result, FoldCase(code_point));
+            pos += length;
+        }
+
+        return result;
+    }
+
+    StopNameIndex::StopNameIndex(const vector<string_view>& names, const vector<bool>& excluded) {
+        vector<string> keys;
+        keys.reserve(names.size());
+        for (string_view name : names) {
+            keys.push_back(NormalizeName(name));
+        }
+
+        vector<uint32_t> order;
+        order.reserve(names.size());
+        for (uint32_t id = 0; id < names.size(); ++id) {
+            if (id >= excluded.size() || !excluded[id]) {
+                order.push_back(id);
+            }
+        }
+        stable_sort(order.begin(), order.end(), [&keys](uint32_t lhs, uint32_t rhs) {
+            return keys[lhs] < keys[rhs];
+        });
+
+        data_.offsets.reserve(names.size() + 1);
+        data_.stop_ids.reserve(names.size());
+        data_.offsets.push_back(0);
+        for (uint32_t id : order) {
+            data_.keys += keys[id];
+            data_.offsets.push_back(static_cast<uint32_t>(data_.keys.size()));
+            data_.stop_ids.push_back(id);
+        }
+    }
+
+    StopNameIndex::StopNameIndex(NameIndexData data)
+        : data_(move(data)) {
+        if (data_.offsets.empty()) {
+            data_.offsets.push_back(0);
+        }
+    }
+
+    const NameIndexData& StopNameIndex::GetData() const {
+        return data_;
+    }
+
+    string_view StopNameIndex::GetKey(size_t index) const {
+        return string_view(data_.keys).substr(data_.offsets[index], data_.offsets[index + 1] - data_.offsets[index]);
+    }
+
+    vector<size_t> StopNameIndex::FindByPrefix(string_view prefix, size_t count) const {
+        const string key = NormalizeName(prefix);
+        const size_t size = data_.stop_ids.size();
+
+        //Бинарный поиск первого названия не меньше префикса
+        size_t left = 0;
+        size_t right = size;
+        while (left < right) {
+            const size_t middle = left + (right - left) / 2;
+            if (GetKey(middle) < key) {
+                left = middle + 1;
+            }
+            else {
+                right = middle;
+            }
+        }
+
+        //count == 0 - без ограничения
+        const size_t limit = count == 0 ? size : count;
+        vector<size_t> result;
+        for (size_t i = left; i < size && result.size() < limit; ++i) {
+            if (GetKey(i).substr(0, key.size()) != key) {
+                break;
+            }
+            result.push_back(data_.stop_ids[i]);
+        }
+
+        return result;
+    }
+}
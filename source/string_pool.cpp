@@ -0,0 +1,46 @@
+#include "string_pool.h"
+
+#include <algorithm>
+
+namespace string_pool {
+
+    using namespace std;
+
+    string_view StringPool::Intern(string_view str) {
+        if (str.empty()) {
+            return {};
+        }
+
+        if (const auto iter = strings_.find(str); iter != strings_.end()) {
+            return *iter;
+        }
+
+        char* data = Allocate(str.size());
+        copy(str.begin(), str.end(), data);
+
+        const string_view result(data, str.size());
+        strings_.insert(result);
+        return result;
+    }
+
+    size_t StringPool::GetSize() const {
+        return strings_.size();
+    }
+
+    char* StringPool::Allocate(size_t size) {
+        //Длинная строка получает свой блок, текущий блок продолжает заполняться
+        if (size > BLOCK_SIZE / 4) {
+            large_blocks_.push_back(make_unique<char[]>(size));
+            return large_blocks_.back().get();
+        }
+
+        if (block_used_ + size > BLOCK_SIZE) {
+            blocks_.push_back(make_unique<char[]>(BLOCK_SIZE));
+            block_used_ = 0;
+        }
+
+        char* data = blocks_.back().get() + block_used_;
+        block_used_ += size;
+        return data;
+    }
+}
@@ -0,0 +1,185 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <iterator>
+#include <string_view>
+
+namespace thread_pool {
+
+    using namespace std;
+
+    namespace {
+        //Число частей на поток: чем больше, тем ровнее нагрузка при разной стоимости индексов
+        const size_t CHUNKS_PER_THREAD = 32;
+    }
+
+    ThreadPool::ThreadPool(size_t threads)
+        : queues_(max<size_t>(threads, 1))
+        , stats_(queues_.size()) {
+        workers_.reserve(queues_.size() - 1);
+        for (size_t i = 1; i < queues_.size(); ++i) {
+            //Поток 0 - вызывающий
+            workers_.emplace_back([this, i]() { WorkerLoop(i); });
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            lock_guard lock(mutex_);
+            is_stopped_ = true;
+        }
+        task_ready_.notify_all();
+        for (thread& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    size_t ThreadPool::GetThreadCount() const {
+        return queues_.size();
+    }
+
+    const vector<ThreadPool::WorkerStats>& ThreadPool::GetStats() const {
+        return stats_;
+    }
+
+    void ThreadPool::ParallelFor(size_t count, const Task& task) {
+        if (count == 0) {
+            return;
+        }
+
+        //Части раскладываются по очередям подряд, чтобы соседние индексы обрабатывал один поток
+        const size_t threads = GetThreadCount();
+        const size_t grain = max<size_t>(count / (threads * CHUNKS_PER_THREAD), 1);
+        const size_t chunk_count = (count + grain - 1) / grain;
+        for (size_t i = 0; i < threads; ++i) {
+            lock_guard lock(queues_[i].mutex);
+            for (size_t chunk = chunk_count * i / threads; chunk < chunk_count * (i + 1) / threads; ++chunk) {
+                queues_[i].chunks.emplace_back(chunk * grain, min(count, (chunk + 1) * grain));
+            }
+        }
+        chunks_left_ = chunk_count;
+
+        {
+            lock_guard lock(mutex_);
+            task_ = &task;
+            running_ = workers_.size();
+            ++generation_;
+        }
+        task_ready_.notify_all();
+
+        RunChunks(task, 0);
+
+        unique_lock lock(mutex_);
+        task_done_.wait(lock, [this]() { return running_ == 0; });
+        task_ = nullptr;
+    }
+
+    void ThreadPool::WorkerLoop(size_t index) {
+        size_t done_generation = 0;
+        while (true) {
+            const Task* task = nullptr;
+            {
+                unique_lock lock(mutex_);
+                task_ready_.wait(lock, [this, done_generation]() { return is_stopped_ || generation_ != done_generation; });
+                if (is_stopped_) {
+                    return;
+                }
+                done_generation = generation_;
+                task = task_;
+            }
+
+            RunChunks(*task, index);
+
+            {
+                lock_guard lock(mutex_);
+                --running_;
+            }
+            task_done_.notify_one();
+        }
+    }
+
+    void ThreadPool::RunChunks(const Task& task, size_t index) {
+        using Clock = chrono::steady_clock;
+        WorkerStats& stats = stats_[index];
+        const Clock::time_point start = Clock::now();
+        Clock::duration busy{ 0 };
+
+        Range chunk;
+        while (chunks_left_.load(memory_order_acquire) > 0) {
+            if (!PopChunk(index, chunk)) {
+                if (StealChunks(index)) {
+                    ++stats.steals;
+                }
+                else {
+                    //Оставшиеся части уже взяты или переносятся другим потоком
+                    this_thread::yield();
+                }
+                continue;
+            }
+
+            const Clock::time_point chunk_start = Clock::now();
+            task(chunk.first, chunk.second);
+            busy += Clock::now() - chunk_start;
+
+            stats.items += chunk.second - chunk.first;
+            ++stats.chunks;
+        }
+
+        stats.busy += chrono::duration_cast<chrono::nanoseconds>(busy);
+        stats.idle += chrono::duration_cast<chrono::nanoseconds>(Clock::now() - start - busy);
+    }
+
+    bool ThreadPool::PopChunk(size_t index, Range& chunk) {
+        WorkerQueue& queue = queues_[index];
+        lock_guard lock(queue.mutex);
+        if (queue.chunks.empty()) {
+            return false;
+        }
+        chunk = queue.chunks.front();
+        queue.chunks.pop_front();
+        chunks_left_.fetch_sub(1, memory_order_acq_rel);
+        return true;
+    }
+
+    bool ThreadPool::StealChunks(size_t index) {
+        const size_t threads = GetThreadCount();
+        for (size_t step = 1; step < threads; ++step) {
+            WorkerQueue& victim = queues_[(index + step) % threads];
+
+            //Половина частей с конца очереди, где лежат индексы, до которых владелец дойдёт позже всего
+            deque<Range> stolen;
+            {
+                lock_guard lock(victim.mutex);
+                const size_t stolen_count = (victim.chunks.size() + 1) / 2;
+                if (stolen_count == 0) {
+                    continue;
+                }
+                const auto from = victim.chunks.end() - stolen_count;
+                stolen.assign(make_move_iterator(from), make_move_iterator(victim.chunks.end()));
+                victim.chunks.erase(from, victim.chunks.end());
+            }
+
+            WorkerQueue& queue = queues_[index];
+            lock_guard lock(queue.mutex);
+            queue.chunks.insert(queue.chunks.end(), stolen.begin(), stolen.end());
+            return true;
+        }
+        return false;
+    }
+
+    void PrintStats(const ThreadPool& pool, std::ostream& out) {
+        const auto to_ms = [](chrono::nanoseconds duration) {
+            return chrono::duration<double, milli>(duration).count();
+        };
+
+        const auto& stats = pool.GetStats();
+        for (size_t i = 0; i < stats.size(); ++i) {
+            out << "{\"worker\":"sv << i
+                << ",\"items\":"sv << stats[i].items
+                << ",\"chunks\":"sv << stats[i].chunks
+                << ",\"steals\":"sv << stats[i].steals
+                << ",\"busy_ms\":"sv << to_ms(stats[i].busy)
+                << ",\"idle_ms\":"sv << to_ms(stats[i].idle) << "}\n"sv;
+        }
+    }
+}
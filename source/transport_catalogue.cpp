@@ -4,111 +4,261 @@ namespace directory {
 
     using namespace std;
 
+    TransportCatalogue::TransportCatalogue(const TransportCatalogue& other)
+        : names_(other.names_) {
+        //Удалённые остановки и автобусы тоже переносятся, чтобы сохранить номера
+        for (const Stop& stop : other.stops_) {
+            AddStation(stop.station_name, stop.coordinates);
+            if (stop.is_removed) {
+                RemoveStation(stop.station_name);
+            }
+        }
+
+        for (const auto& [from, to, distance] : other.GetAllDistances()) {
+            RestoreDistance(from, to, distance);
+        }
+
+        vector<BusStat> stats = other.GetAllBusStats();
+        size_t bus_id = 0;
+        for (const Bus& bus : other.buses_) {
+            if (bus.is_removed) {
+                buses_.emplace_back(bus.bus_name, 0, 0, bus.is_roundtrip);
+                buses_.back().is_removed = true;
+                ++bus_id;
+                continue;
+            }
+            RestoreRoute(bus.bus_name, other.GetStopIdsForBus(bus), bus.is_roundtrip, stats.at(bus_id++));
+        }
+
+        vector<vector<uint32_t>> stop_bus_ids = other.GetAllStopBusIds();
+        for (size_t stop_id = 0; stop_id < stop_bus_ids.size(); ++stop_id) {
+            RestoreBusesForStop(stop_id, stop_bus_ids[stop_id]);
+        }
+    }
+
     //добавление маршрута в базу
-    void TransportCatalogue::AddRoute(std::string_view bus, std::vector<std::string>& stops, bool is_roundtrip) {
-        std::string name = { bus.begin(), bus.end() };
-        size_t stops_on_route = 0;
+    void TransportCatalogue::AddRoute(std::string_view bus, const std::vector<std::string_view>& stops, bool is_roundtrip) {
+        buses_.emplace_back(names_->Intern(bus), 0, 0, is_roundtrip);
+        Bus& new_bus = buses_.back();
+
+        std::vector<std::string_view> vector_stops;
+        for (const auto& s : stops) {
+            vector_stops.push_back(stop_to_stop.at(s)->station_name);
+        }
+
+        for (string_view stop : vector_stops) {
+            stop_to_bus[stop].push_back(&new_bus);
+        }
+        bus_to_stops[new_bus.bus_name] = move(vector_stops);
+
+        ComputeBusStat(new_bus);
+    }
+
+    void TransportCatalogue::ComputeBusStat(Bus& bus) {
+        const vector<string_view>& stops = bus_to_stops.at(bus.bus_name);
         size_t coefficient = 0;
 
-        if (is_roundtrip) {
+        if (bus.is_roundtrip) {
             //круговой
-            stops_on_route = stops.size();
+            bus.stops_on_route = stops.size();
             coefficient = 1;
         }
         else {
             //туда-обратно
-            stops_on_route = stops.size() * 2 - 1;
+            bus.stops_on_route = stops.size() * 2 - 1;
             coefficient = 2;
         }
 
-        set temp_stops(stops.begin(), stops.end());
-        buses_.emplace_back(name, stops_on_route, temp_stops.size(), is_roundtrip);
-        const string_view bus_name = buses_.back().bus_name;
-
-        std::vector<std::string_view> vector_stops;
-        for (const auto& s : stops) {
-            vector_stops.push_back(stop_to_stop.at(s)->station_name);
-        }
+        bus.unique_stops = set<string_view>(stops.begin(), stops.end()).size();
 
-        bus_to_stops[bus_name] = vector_stops;
-
-        double length = 0;
         uint64_t route_length = 0;
-        ::geo::Coordinates from;
-        ::geo::Coordinates to;
-        bool flag = false;
+        std::vector<::geo::PreparedCoordinates> points;
+        points.reserve(stops.size());
 
-        for (auto iter = bus_to_stops.at(bus_name).begin(); iter != bus_to_stops.at(bus_name).end(); ++iter) {
+        for (auto iter = stops.begin(); iter != stops.end(); ++iter) {
             auto iter_next = std::next(iter);
-            if (iter_next != bus_to_stops.at(bus_name).end()) {
+            if (iter_next != stops.end()) {
                 route_length += GetDistanceBetweenStops(*iter, *iter_next);
             }
 
-            for (const Stop& s : stops_) {
-                if (s.station_name == *iter) {
-                    if (flag) {
-                        from = to;
-                        to = s.coordinates;
-                        length += std::abs(::geo::ComputeDistance(from, to));
-                    }
-                    else {
-                        flag = true;
-                        to = s.coordinates;
-                    }
-                    break;
-                }
-            }
-            stop_to_bus[*iter].push_back(&buses_.back());
+            points.push_back(stop_to_stop.at(*iter)->prepared_coordinates);
         }
 
+        const double length = ::geo::ComputeRouteDistance(points);
+
         if (coefficient == 2) {
             //The bus needs to turn around and go back.
-            route_length += GetDistanceBetweenStops(*(bus_to_stops.at(bus_name).end() - 1), *(bus_to_stops.at(bus_name).end() - 1));
-            flag = false;
+            route_length += GetDistanceBetweenStops(*(stops.end() - 1), *(stops.end() - 1));
 
-            for (auto iter = bus_to_stops.at(bus_name).rbegin(); iter != bus_to_stops.at(bus_name).rend(); ++iter) {
+            for (auto iter = stops.rbegin(); iter != stops.rend(); ++iter) {
                 auto iter_next = std::next(iter);
 
-                if (iter_next != bus_to_stops.at(bus_name).rend()) {
+                if (iter_next != stops.rend()) {
                     route_length += GetDistanceBetweenStops(*iter, *iter_next);
                 }
             }
         }
 
-        buses_.back().route_length = route_length;
-        buses_.back().curvature = route_length / (length * coefficient);
+        bus.route_length = route_length;
+        bus.curvature = route_length / (length * coefficient);
+    }
+
+    void TransportCatalogue::ComputeBusStatsForStop(string_view stop) {
+        const vector<Bus*>& buses = stop_to_bus.at(stop);
+        //автобус встречается в списке столько раз, сколько проходит через остановку
+        const unordered_set<Bus*> unique_buses(buses.begin(), buses.end());
+        for (Bus* bus : unique_buses) {
+            ComputeBusStat(*bus);
+        }
+    }
+
+    Bus* TransportCatalogue::FindBus(string_view bus) {
+        for (Bus& item : buses_) {
+            if (!item.is_removed && item.bus_name == bus) {
+                return &item;
+            }
+        }
+        return nullptr;
+    }
+
+    void TransportCatalogue::RemoveBusFromStops(Bus* bus) {
+        for (string_view stop : bus_to_stops.at(bus->bus_name)) {
+            auto& buses = stop_to_bus.at(stop);
+            buses.erase(std::remove(buses.begin(), buses.end(), bus), buses.end());
+        }
+    }
+
+    void TransportCatalogue::UpdateStation(string_view stop, ::geo::Coordinates coordinates) {
+        const auto iter = stop_to_stop.find(stop);
+        if (iter == stop_to_stop.end()) {
+            AddStation(stop, coordinates);
+            return;
+        }
+
+        iter->second->coordinates = coordinates;
+        iter->second->prepared_coordinates = ::geo::PrepareCoordinates(coordinates);
+        ComputeBusStatsForStop(iter->first);
+    }
+
+    void TransportCatalogue::RemoveStation(string_view stop) {
+        Stop* removed = stop_to_stop.at(stop);
+        if (!stop_to_bus.at(stop).empty()) {
+            throw invalid_argument("Stop "s + string(stop) + " is used by buses"s);
+        }
+
+        for (auto iter = distances_.begin(); iter != distances_.end();) {
+            if (iter->first.first == removed || iter->first.second == removed) {
+                iter = distances_.erase(iter);
+            }
+            else {
+                ++iter;
+            }
+        }
+
+        removed->is_removed = true;
+        stop_to_bus.erase(removed->station_name);
+        stop_to_stop.erase(removed->station_name);
+    }
+
+    void TransportCatalogue::UpdateRoute(string_view bus, const vector<string_view>& stops, bool is_roundtrip) {
+        Bus* found = FindBus(bus);
+        if (found == nullptr) {
+            AddRoute(bus, stops, is_roundtrip);
+            return;
+        }
+
+        std::vector<std::string_view> vector_stops;
+        for (const auto& s : stops) {
+            vector_stops.push_back(stop_to_stop.at(s)->station_name);
+        }
+
+        RemoveBusFromStops(found);
+        for (string_view stop : vector_stops) {
+            stop_to_bus[stop].push_back(found);
+        }
+        bus_to_stops[found->bus_name] = move(vector_stops);
+
+        found->is_roundtrip = is_roundtrip;
+        ComputeBusStat(*found);
+    }
+
+    void TransportCatalogue::RemoveRoute(string_view bus) {
+        Bus* found = FindBus(bus);
+        if (found == nullptr) {
+            throw invalid_argument("Unknown bus "s + string(bus));
+        }
+
+        RemoveBusFromStops(found);
+        bus_to_stops.erase(found->bus_name);
+        found->is_removed = true;
+    }
+
+    void TransportCatalogue::UpdateDistance(string_view from, string_view to, uint64_t distance) {
+        distances_[pair(stop_to_stop.at(from), stop_to_stop.at(to))] = distance;
+        ComputeBusStatsForStop(from);
+    }
+
+    void TransportCatalogue::RemoveDistance(string_view from, string_view to) {
+        distances_.erase(pair(stop_to_stop.at(from), stop_to_stop.at(to)));
+        ComputeBusStatsForStop(from);
+    }
+
+    void TransportCatalogue::RestoreRoute(std::string_view bus, const std::vector<uint32_t>& stop_ids, bool is_roundtrip, const BusStat& stat) {
+        buses_.emplace_back(names_->Intern(bus), stat.stops_on_route, stat.unique_stops, is_roundtrip);
+        buses_.back().route_length = stat.route_length;
+        buses_.back().curvature = stat.curvature;
+
+        std::vector<std::string_view> vector_stops;
+        vector_stops.reserve(stop_ids.size());
+        for (uint32_t id : stop_ids) {
+            vector_stops.push_back(stops_.at(id).station_name);
+        }
+
+        bus_to_stops[buses_.back().bus_name] = move(vector_stops);
+    }
+
+    void TransportCatalogue::RestoreBusesForStop(size_t stop_id, const std::vector<uint32_t>& bus_ids) {
+        if (bus_ids.empty()) {
+            return;
+        }
+        auto& buses = stop_to_bus[stops_.at(stop_id).station_name];
+        buses.reserve(bus_ids.size());
+        for (uint32_t id : bus_ids) {
+            buses.push_back(&buses_.at(id));
+        }
+    }
+
+    void TransportCatalogue::RestoreDistance(size_t from_id, size_t to_id, uint64_t distance) {
+        distances_[pair(&stops_.at(from_id), &stops_.at(to_id))] = distance;
     }
 
     //добавление остановки в базу
     void TransportCatalogue::AddStation(string_view stop, ::geo::Coordinates coordinates) {
-        stops_.emplace_back(stop, coordinates);
+        stops_.emplace_back(names_->Intern(stop), coordinates, stops_.size());
 
         string_view curr_stop = stops_.back().station_name;
         stop_to_stop[curr_stop] = &stops_.back();
         stop_to_bus[curr_stop] = {};
     }
 
-    void TransportCatalogue::AddStationDistance(string_view stop, unordered_map<string, uint64_t, std::hash<std::string_view>>& distance_to_stop) {
-        for (const auto& [destination_stop, distance] : distance_to_stop) {
-            SetDistanceBetweenStops(stop, destination_stop, distance);
-        }
-    }
-
     //получение информации о маршруте
     //Bus X: R stops on route, U unique stops, L route length
-    Bus* TransportCatalogue::GetInfoAboutRoute(string_view route) {
-        for (Bus& bus : buses_) {
-            if (bus.bus_name == route) {
+    const Bus* TransportCatalogue::GetInfoAboutRoute(string_view route) const {
+        for (const Bus& bus : buses_) {
+            if (!bus.is_removed && bus.bus_name == route) {
                 return &bus;
             }
         }
-        static Bus empty_bus("", 0, 0, false);
+        static const Bus empty_bus("", 0, 0, false);
         return &empty_bus;
     }
     
-    vector<Bus*> TransportCatalogue::GetBuses() {
-        vector<Bus*> result;
-        for (Bus& bus : buses_) {
+    vector<const Bus*> TransportCatalogue::GetBuses() const {
+        vector<const Bus*> result;
+        for (const Bus& bus : buses_) {
+            if (bus.is_removed) {
+                continue;
+            }
             result.push_back(&bus);
         }
 
@@ -124,7 +274,7 @@ namespace directory {
     }
     
     //метод для получения списка автобусов по остановке
-    tuple<bool, set<string_view> > TransportCatalogue::GetBusesForStop(string_view station) {
+    tuple<bool, set<string_view> > TransportCatalogue::GetBusesForStop(string_view station) const {
         if (stop_to_bus.count(station) > 0) {
             set<string_view> retult;
             for (auto& bus : stop_to_bus.at(station)) {
@@ -137,7 +287,7 @@ namespace directory {
         }
     }
 
-    uint64_t TransportCatalogue::GetDistanceBetweenStops(std::string_view from, std::string_view to) {
+    uint64_t TransportCatalogue::GetDistanceBetweenStops(std::string_view from, std::string_view to) const {
         if (distances_.count({ stop_to_stop.at(from), stop_to_stop.at(to) })>0) {
             return distances_.at({ stop_to_stop.at(from), stop_to_stop.at(to) });
         }
@@ -153,7 +303,7 @@ namespace directory {
         distances_[pair(stop_to_stop[stop_from], stop_to_stop[stop_to])] = distance_to_stop;
     }
 
-    unordered_map<string_view, ::geo::Coordinates> TransportCatalogue::GetStopsWithCoordinates() {
+    unordered_map<string_view, ::geo::Coordinates> TransportCatalogue::GetStopsWithCoordinates() const {
         unordered_map<string_view, ::geo::Coordinates> result;
         for (const auto& [bus, stops] : bus_to_stops) {
             for (const auto& stop : stops) {
@@ -163,7 +313,122 @@ namespace directory {
         return result;
     }
     
-    size_t TransportCatalogue::GetCountStops() {
+    const deque<Stop>& TransportCatalogue::GetAllStops() const {
+        return stops_;
+    }
+
+    const deque<Bus>& TransportCatalogue::GetAllBuses() const {
+        return buses_;
+    }
+
+    vector<uint32_t> TransportCatalogue::GetStopIdsForBus(const Bus& bus) const {
+        vector<uint32_t> result;
+        for (string_view stop : bus_to_stops.at(bus.bus_name)) {
+            result.push_back(static_cast<uint32_t>(stop_to_stop.at(stop)->id));
+        }
+        return result;
+    }
+
+    vector<tuple<uint32_t, uint32_t, uint64_t>> TransportCatalogue::GetAllDistances() const {
+        vector<tuple<uint32_t, uint32_t, uint64_t>> result;
+        result.reserve(distances_.size());
+        for (const auto& [stops, distance] : distances_) {
+            result.emplace_back(static_cast<uint32_t>(stops.first->id), static_cast<uint32_t>(stops.second->id), distance);
+        }
+        return result;
+    }
+
+    vector<BusStat> TransportCatalogue::GetAllBusStats() const {
+        vector<BusStat> result;
+        result.reserve(buses_.size());
+        for (const Bus& bus : buses_) {
+            result.push_back({ bus.stops_on_route, bus.unique_stops, bus.route_length, bus.curvature });
+        }
+        return result;
+    }
+
+    vector<vector<uint32_t>> TransportCatalogue::GetAllStopBusIds() const {
+        unordered_map<const Bus*, uint32_t> bus_ids;
+        for (const Bus& bus : buses_) {
+            bus_ids.emplace(&bus, static_cast<uint32_t>(bus_ids.size()));
+        }
+
+        vector<vector<uint32_t>> result;
+        result.reserve(stops_.size());
+        for (const Stop& stop : stops_) {
+            vector<uint32_t> ids;
+            if (stop.is_removed) {
+                result.push_back(move(ids));
+                continue;
+            }
+            for (const Bus* bus : stop_to_bus.at(stop.station_name)) {
+                ids.push_back(bus_ids.at(bus));
+            }
+            sort(ids.begin(), ids.end());
+            ids.erase(unique(ids.begin(), ids.end()), ids.end());
+            result.push_back(move(ids));
+        }
+        return result;
+    }
+
+    size_t TransportCatalogue::GetCountStops() const {
         return stops_.size();
     }
+
+    vector<::geo::Coordinates> TransportCatalogue::GetAllStopCoordinates() const {
+        vector<::geo::Coordinates> result;
+        result.reserve(stops_.size());
+        for (const Stop& stop : stops_) {
+            result.push_back(stop.coordinates);
+        }
+        return result;
+    }
+
+    string_view TransportCatalogue::GetStopName(size_t stop_id) const {
+        return stops_.at(stop_id).station_name;
+    }
+
+    vector<string_view> TransportCatalogue::GetAllStopNames() const {
+        vector<string_view> result;
+        result.reserve(stops_.size());
+        for (const Stop& stop : stops_) {
+            result.push_back(stop.station_name);
+        }
+        return result;
+    }
+
+    vector<bool> TransportCatalogue::GetRemovedStops() const {
+        vector<bool> result;
+        result.reserve(stops_.size());
+        for (const Stop& stop : stops_) {
+            result.push_back(stop.is_removed);
+        }
+        return result;
+    }
+
+    string_view TransportCatalogue::FindStopName(string_view stop) const {
+        const auto iter = stop_to_stop.find(stop);
+        return iter == stop_to_stop.end() ? string_view() : iter->first;
+    }
+
+    optional<size_t> TransportCatalogue::FindStopId(string_view stop) const {
+        const auto iter = stop_to_stop.find(stop);
+        if (iter == stop_to_stop.end()) {
+            return nullopt;
+        }
+        return iter->second->id;
+    }
+
+    optional<size_t> TransportCatalogue::FindBusId(string_view bus) const {
+        for (size_t bus_id = 0; bus_id < buses_.size(); ++bus_id) {
+            if (!buses_[bus_id].is_removed && buses_[bus_id].bus_name == bus) {
+                return bus_id;
+            }
+        }
+        return nullopt;
+    }
+
+    string_view TransportCatalogue::GetBusName(size_t bus_id) const {
+        return buses_.at(bus_id).bus_name;
+    }
 }
\ No newline at end of file
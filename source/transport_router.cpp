@@ -6,6 +6,15 @@ namespace transport_router {
 
     using namespace std;
 
+    namespace {
+        //Вершина графа для начальной (конечной) остановки маршрута
+        struct RouteEnd {
+            ::graph::VertexId vertex;
+            double walk_time;
+            string_view stop;
+        };
+    }
+
     TransportRouter::TransportRouter(size_t vertex_count)
         : dwg(vertex_count) {
     }
@@ -20,15 +29,19 @@ namespace transport_router {
 
         TransportRouter::Ids new_id;
         new_id.id = current_id++;
+        if (new_id.id >= dwg.GetVertexCount()) {
+            //остановка добавлена при изменении базы
+            dwg.AddVertex();
+        }
         new_id.is_transfer = is_transfer;
-        new_id.name = { stop.begin(), stop.end() };
+        new_id.name = stop;
 
         id_s_.emplace_back(move(new_id));
 
         return id_s_.back().id;
     }
 
-    TransportRouter::Ids* TransportRouter::GetStructForName(std::string_view stop, bool is_transfer) {
+    const TransportRouter::Ids* TransportRouter::GetStructForName(std::string_view stop, bool is_transfer) const {
         for (auto iter = id_s_.begin(); iter != id_s_.end(); ++iter) {
             if ((*iter).name == stop.substr() && (*iter).is_transfer == is_transfer) {
                 return &(*iter);
@@ -38,79 +51,94 @@ namespace transport_router {
     }
 
     void TransportRouter::WriteNewEdge(::graph::EdgeId edge_id, EdgeInfo info) {
+        if (bus_edges_ && info.is_bus_type) {
+            (*bus_edges_)[info.bus].push_back(edge_id);
+        }
         edges_id_[edge_id] = info;
     }
 
-    TransportRouter::EdgeInfo* TransportRouter::GetVertexForEdge(::graph::EdgeId edge_id) {
+    const TransportRouter::EdgeInfo* TransportRouter::GetVertexForEdge(::graph::EdgeId edge_id) const {
         return &edges_id_.at(edge_id);
     }
 
-    ::graph::DirectedWeightedGraph<double>& TransportRouter::CreateGraph(::directory::TransportCatalogue& tr, const std::pair<int, double>& routing_settings) {
-        vector<::directory::Bus*> buses = tr.GetBuses();
+    ::graph::DirectedWeightedGraph<double>& TransportRouter::CreateGraph(const ::directory::TransportCatalogue& tr, const std::pair<int, double>& routing_settings) {
+        vector<const ::directory::Bus*> buses = tr.GetBuses();
+
+        for (const ::directory::Bus* bus : buses) {
+            AddBusEdges(tr, routing_settings, bus, false);
+        }
+        return dwg;
+    }
 
-        for (::directory::Bus* bus : buses) {
-            vector<string_view> stops = tr.GetStopsForBus(bus->bus_name);
+    void TransportRouter::AddBusEdges(const ::directory::TransportCatalogue& tr, const std::pair<int, double>& routing_settings, const ::directory::Bus* bus, bool is_update) {
+        vector<string_view> stops = tr.GetStopsForBus(bus->bus_name);
 
-            for (auto iter_from = stops.begin(); iter_from != stops.end(); ++iter_from) {
-                FillInfo(iter_from + 1, stops.end(), 0, tr, routing_settings, 0, bus, GetNewVertexId(*iter_from, false));
+        for (auto iter_from = stops.begin(); iter_from != stops.end(); ++iter_from) {
+            //Ребро ожидания у остановки уже есть, если из неё уже отправлялся автобус
+            const bool has_wait = is_update && GetStructForName(*iter_from, false) != nullptr;
 
-                //Ребро одижания автобуса wait
-                auto id_from_wait = GetNewVertexId(*iter_from, true);
-                auto id_to_wait = GetNewVertexId(*iter_from, false);
-                auto edge_wait = dwg.AddEdge({ id_from_wait, id_to_wait,  static_cast<double>(routing_settings.first) });
+            FillInfo(iter_from + 1, stops.end(), 0, tr, routing_settings, 0, bus, GetNewVertexId(*iter_from, false));
 
-                ::transport_router::TransportRouter::EdgeInfo info_wait;
-                info_wait.id_from = id_from_wait;
-                info_wait.id_to = id_to_wait;
-                info_wait.time = static_cast<double>(routing_settings.first);
-                info_wait.is_bus_type = false;
-                info_wait.stop_name = *iter_from;
-                WriteNewEdge(edge_wait, info_wait);
+            if (has_wait) {
+                continue;
             }
 
-            if (!bus->is_roundtrip) {
-                //Маршрут не круговой, поэтому надо ехать обратно...
-                for (auto iter_from = stops.rbegin(); iter_from != stops.rend(); ++iter_from) {
-                    FillInfo(iter_from + 1, stops.rend(), 0, tr, routing_settings, 0, bus, GetNewVertexId(*iter_from, false));
-                }
+            //Ребро одижания автобуса wait
+            auto id_from_wait = GetNewVertexId(*iter_from, true);
+            auto id_to_wait = GetNewVertexId(*iter_from, false);
+            auto edge_wait = dwg.AddEdge({ id_from_wait, id_to_wait,  static_cast<double>(routing_settings.first) });
+
+            ::transport_router::TransportRouter::EdgeInfo info_wait{};
+            info_wait.id_from = id_from_wait;
+            info_wait.id_to = id_to_wait;
+            info_wait.time = static_cast<double>(routing_settings.first);
+            info_wait.is_bus_type = false;
+            info_wait.span_count = 0;
+            info_wait.stop_name = *iter_from;
+            WriteNewEdge(edge_wait, info_wait);
+        }
+
+        if (!bus->is_roundtrip) {
+            //Маршрут не круговой, поэтому надо ехать обратно...
+            for (auto iter_from = stops.rbegin(); iter_from != stops.rend(); ++iter_from) {
+                FillInfo(iter_from + 1, stops.rend(), 0, tr, routing_settings, 0, bus, GetNewVertexId(*iter_from, false));
             }
-            else {
-                //круговой
-                auto iter_from = stops.end() - 1;
-                auto id_from = GetNewVertexId(*iter_from, false);
-                int span_count = 0;
+        }
+        else {
+            //круговой
+            auto iter_from = stops.end() - 1;
+            auto id_from = GetNewVertexId(*iter_from, false);
+            int span_count = 0;
 
-                uint64_t dis = tr.GetDistanceBetweenStops(*iter_from, *stops.begin());
-                //Ребро bus
-                auto id_to = GetNewVertexId(*stops.begin(), true);
+            uint64_t dis = tr.GetDistanceBetweenStops(*iter_from, *stops.begin());
+            //Ребро bus
+            auto id_to = GetNewVertexId(*stops.begin(), true);
 
-                //Метры переводим в км и часы в минуты
-                double time = (dis / 1000.0) * 60 / routing_settings.second;
+            //Метры переводим в км и часы в минуты
+            double time = (dis / 1000.0) * 60 / routing_settings.second;
 
-                auto edge_bus = dwg.AddEdge({ id_from, id_to, time });
+            auto edge_bus = dwg.AddEdge({ id_from, id_to, time });
 
-                ::transport_router::TransportRouter::EdgeInfo info_bus;
-                info_bus.id_from = id_from;
-                info_bus.id_to = id_to;
-                info_bus.time = time;
-                info_bus.span_count = ++span_count;
-                info_bus.bus = bus->bus_name;
-                info_bus.is_bus_type = true;
+            ::transport_router::TransportRouter::EdgeInfo info_bus;
+            info_bus.id_from = id_from;
+            info_bus.id_to = id_to;
+            info_bus.time = time;
+            info_bus.span_count = ++span_count;
+            info_bus.bus = bus->bus_name;
+            info_bus.is_bus_type = true;
 
-                WriteNewEdge(edge_bus, info_bus);
+            WriteNewEdge(edge_bus, info_bus);
 
-                FillInfo(stops.begin() + 1, iter_from, dis, tr, routing_settings, span_count, bus, id_from);
-            }
+            FillInfo(stops.begin() + 1, iter_from, dis, tr, routing_settings, span_count, bus, id_from);
         }
-        return dwg;
     }
 
     ::graph::DirectedWeightedGraph<double>& TransportRouter::Restore(std::vector <::graph::Edge<double>>& edges, ::graph::VertexId& curr_id,
         std::deque<Ids>& id_s, std::map<::graph::EdgeId, EdgeInfo>& edges_id) {
 
         current_id = curr_id;
-        id_s_ = id_s;
-        edges_id_ = edges_id;
+        id_s_ = std::move(id_s);
+        edges_id_ = std::move(edges_id);
 
         for (const auto& edge : edges) {
             dwg.AddEdge(edge);
@@ -119,13 +147,13 @@ namespace transport_router {
         return dwg;
     }
 
-    ::graph::DirectedWeightedGraph<double>& TransportRouter::GetGraph() {
+    const ::graph::DirectedWeightedGraph<double>& TransportRouter::GetGraph() const {
         return dwg;
     }
 
-    TransportRouter::RouteInfo TransportRouter::GetRoute(::graph::Router<double>& router, std::string_view from, std::string_view to) {
+    TransportRouter::RouteInfo TransportRouter::GetRoute(const ::graph::Router<double>& router, std::string_view from, std::string_view to) const {
 
-        deque<TransportRouter::EdgeInfo*> result;
+        deque<const TransportRouter::EdgeInfo*> result;
 
         if (GetStructForName(from, true) != nullptr && GetStructForName(to, true) != nullptr) {
             auto built_route = router.BuildRoute(GetStructForName(from, true)->id, GetStructForName(to, true)->id);
@@ -136,15 +164,113 @@ namespace transport_router {
                     result.push_back(GetVertexForEdge(edge));
                 }
 
-                return { result, built_route.value().weight };
+                return RouteInfo{ result, built_route.value().weight, nullopt, nullopt };
+            }
+        }
+        return RouteInfo{ result, -1, nullopt, nullopt };
+    }
+
+    TransportRouter::RouteInfo TransportRouter::GetRoute(const StopsWithWalkTime& from, const StopsWithWalkTime& to) const {
+        return GetRoutes(from, { to }).front();
+    }
+
+    vector<TransportRouter::RouteInfo> TransportRouter::GetRoutes(const StopsWithWalkTime& from, const vector<StopsWithWalkTime>& to) const {
+        vector<RouteInfo> result(to.size(), RouteInfo{ {}, -1, nullopt, nullopt });
+
+        //Остановки без вершины в графе пропускаются, название хранится рядом с вершиной
+        const auto get_route_ends = [this](const StopsWithWalkTime& stops) {
+            vector<RouteEnd> ends;
+            for (const auto& [stop, walk_time] : stops) {
+                if (const Ids* ids = GetStructForName(stop, true)) {
+                    ends.push_back(RouteEnd{ ids->id, walk_time, stop });
+                }
+            }
+            return ends;
+        };
+
+        const vector<RouteEnd> sources = get_route_ends(from);
+        vector<vector<RouteEnd>> targets;
+        targets.reserve(to.size());
+        vector<::graph::VertexId> target_ids;
+        for (const StopsWithWalkTime& stops : to) {
+            targets.push_back(get_route_ends(stops));
+            for (const RouteEnd& target : targets.back()) {
+                target_ids.push_back(target.vertex);
+            }
+        }
+
+        if (sources.empty() || target_ids.empty()) {
+            return result;
+        }
+
+        vector<pair<::graph::VertexId, double>> source_weights;
+        source_weights.reserve(sources.size());
+        for (const RouteEnd& source : sources) {
+            source_weights.emplace_back(source.vertex, source.walk_time);
+        }
+
+        //Поиск идёт до всех конечных остановок сразу. Расстояния и пути до достигнутых вершин
+        //не зависят от того, когда поиск остановлен, поэтому ответы совпадают с отдельными поисками
+        ::graph::ShortestPathTree<double> tree(dwg, source_weights, target_ids);
+
+        for (size_t i = 0; i < to.size(); ++i) {
+            const RouteEnd* best = nullptr;
+            double best_time = 0;
+            for (const RouteEnd& target : targets[i]) {
+                if (tree.IsReached(target.vertex) && (best == nullptr || tree.GetWeight(target.vertex) + target.walk_time < best_time)) {
+                    best = &target;
+                    best_time = tree.GetWeight(target.vertex) + target.walk_time;
+                }
+            }
+
+            if (best == nullptr) {
+                continue;
+            }
+
+            const ::graph::VertexId source = tree.GetSource(best->vertex);
+
+            RouteInfo& route = result[i];
+            route.total_time = best_time;
+            for (auto edge : tree.GetEdges(best->vertex)) {
+                route.edges.push_back(GetVertexForEdge(edge));
             }
+
+            const auto walk_from = find_if(sources.begin(), sources.end(), [source](const RouteEnd& end) { return end.vertex == source; });
+            route.walk_from = WalkInfo{ walk_from->stop, walk_from->walk_time };
+            route.walk_to = WalkInfo{ best->stop, best->walk_time };
         }
-        return { result, -1 };
+
+        return result;
     }
 
-    void TransportRouter::GetVariable(::graph::VertexId& curr_id, std::deque<Ids>& id_s, std::map<::graph::EdgeId, EdgeInfo>& edges_id) {
+    void TransportRouter::GetVariable(::graph::VertexId& curr_id, std::deque<Ids>& id_s, std::map<::graph::EdgeId, EdgeInfo>& edges_id) const {
         curr_id = current_id;
         id_s = id_s_;
         edges_id = edges_id_;
     }
+
+    void TransportRouter::UpdateBusEdges(const ::directory::TransportCatalogue& tr, const std::pair<int, double>& routing_settings, std::string_view bus_name) {
+        if (!bus_edges_) {
+            bus_edges_.emplace();
+            for (const auto& [edge_id, info] : edges_id_) {
+                if (info.is_bus_type) {
+                    (*bus_edges_)[info.bus].push_back(edge_id);
+                }
+            }
+        }
+
+        const auto iter = bus_edges_->find(bus_name);
+        if (iter != bus_edges_->end()) {
+            for (::graph::EdgeId edge_id : iter->second) {
+                dwg.RemoveEdge(edge_id);
+                edges_id_.erase(edge_id);
+            }
+            bus_edges_->erase(iter);
+        }
+
+        const ::directory::Bus* bus = tr.GetInfoAboutRoute(bus_name);
+        if (!bus->bus_name.empty()) {
+            AddBusEdges(tr, routing_settings, bus, true);
+        }
+    }
 } //namespace transport_router
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "json_reader.h"
+#include "request_handler.h"
+#include "serialization.h"
+#include "transport_catalogue.h"
+
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+    // Буфер потока, который запоминает, сколько байт в него пришло к первому flush
+    class RecordingBuffer : public std::streambuf {
+    public:
+        const std::string& GetText() const {
+            return text_;
+        }
+
+        size_t GetSizeAtFirstSync() const {
+            return size_at_first_sync_;
+        }
+
+    protected:
+        int_type overflow(int_type c) override {
+            if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                text_.push_back(traits_type::to_char_type(c));
+            }
+            return traits_type::not_eof(c);
+        }
+
+        std::streamsize xsputn(const char* data, std::streamsize size) override {
+            text_.append(data, static_cast<size_t>(size));
+            return size;
+        }
+
+        int sync() override {
+            if (!is_synced_) {
+                is_synced_ = true;
+                size_at_first_sync_ = text_.size();
+            }
+            return 0;
+        }
+
+    private:
+        std::string text_;
+        bool is_synced_ = false;
+        size_t size_at_first_sync_ = 0;
+    };
+
+    // Пакет из count запросов Bus
+    std::string MakeBusRequests(int count) {
+        std::ostringstream out;
+        out << "{\"stat_requests\": ["sv;
+        for (int i = 0; i < count; ++i) {
+            out << (i > 0 ? ", "sv : ""sv) << "{\"id\": "sv << i << ", \"type\": \"Bus\", \"name\": \"1\"}"sv;
+        }
+        out << "]}"sv;
+        return out.str();
+    }
+}
+
+// Ответы на первые запросы пакета должны дойти до потока раньше, чем пакет обработан целиком:
+// небольшие ответы не должны ждать заполнения буфера json::Writer
+int main() {
+    ::directory::TransportCatalogue catalogue;
+    ::serialization_space::SerializeVariable serialize_variable;
+    serialize_variable.routing_settings = { 6, 40.0 };
+
+    ::renderer::RequestHandler rh(catalogue, serialize_variable.renderer, serialize_variable.routing_settings);
+    rh.AddStop("A"sv, { 55.611087, 37.20829 });
+    rh.AddStop("B"sv, { 55.595884, 37.209755 });
+    rh.AddDistance("A"sv, "B"sv, 3900);
+    rh.AddBus("1"sv, { "A"sv, "B"sv }, false);
+    rh.SetRouterWithNewGraph();
+
+    ::directory::json_detail::JsonReader reader;
+    std::vector<::directory::json_detail::QueryUpdate> update_queries;
+    std::string path;
+    if (!reader.ReadProcessRequests(MakeBusRequests(2000), update_queries, path)) {
+        std::cerr << "stat_output_test: requests are not read"sv << std::endl;
+        return 1;
+    }
+
+    RecordingBuffer buffer;
+    std::ostream out(&buffer);
+    reader.PrintStatRequests(rh, out, ::json::Writer::Format::COMPACT);
+
+    const size_t total = buffer.GetText().size();
+    const size_t first = buffer.GetSizeAtFirstSync();
+    if (first == 0 || first >= total) {
+        std::cerr << "stat_output_test: first flush after "sv << first << " of "sv << total << " bytes"sv << std::endl;
+        return 1;
+    }
+    std::cout << "stat_output_test: OK, first flush after "sv << first << " of "sv << total << " bytes"sv << std::endl;
+    return 0;
+}